@@ -0,0 +1,205 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    bench_core.cpp
+ * @brief   This file contains the micro-benchmarks of the per release bookkeeping every service pays
+ * @date    18th October 2026
+ *
+ * Usage: bench_core [iterations]
+ * Covers the time math (timeline and stopwatch clock reads, timespec conversions), recording
+ * into the latency histogram and the jitter statistics, the ultrasonic range
+ * filter, the blackboard seqlock and trace_emit. Prints one JSON object per kernel with the mean and
+ * p99 cost of a single call.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rt_time.h"
+#include "jitter_stats.h"
+#include "latency_histogram.h"
+#include "service_stats.h"
+#include "blackboard.h"
+#include "trace.h"
+#include "range_filter.h"
+
+#define OPS_PER_SAMPLE (1000)   // one sample times this many calls to rise above the clock read cost
+
+static latency_histogram_t hist;
+static latency_histogram_t target;
+static jitter_stats_t jitter;
+static range_filter_t range_filter;
+
+// Keeps the compiler from dropping the measured work, or folding it across iterations under LTO
+static volatile uint64_t sink;
+
+static inline void clobber(void)
+{
+    asm volatile("" : : : "memory");
+}
+
+static void report(const char *name, int iterations)
+{
+    printf("{\"bench\":\"%s\",\"iterations\":%d,\"mean_ns\":%.1f,\"p99_ns\":%.1f,\"max_ns\":%.1f}\n",
+           name, iterations * OPS_PER_SAMPLE, hist.sum_ns.load() / (double)hist.count.load() / OPS_PER_SAMPLE,
+           latency_histogram_percentile(&hist, 99.0) / (double)OPS_PER_SAMPLE, hist.max_ns.load() / (double)OPS_PER_SAMPLE);
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = (argc > 1) ? atoi(argv[1]) : 1000;
+    struct timespec ts;
+    vehicle_snapshot_t snap;
+    range_decision_t decision;
+    uint64_t t0, acc;
+
+    service_stats_init();
+    blackboard_init();
+
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        acc = 0;
+        for(int k = 0; k < OPS_PER_SAMPLE; k++) acc += rt_now();
+        latency_histogram_record(&hist, rt_now() - t0);
+        sink = acc;
+    }
+    report("clock_monotonic_read", iterations);
+
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        acc = 0;
+        for(int k = 0; k < OPS_PER_SAMPLE; k++) acc += rt_now_raw();
+        latency_histogram_record(&hist, rt_now() - t0);
+        sink = acc;
+    }
+    report("clock_monotonic_raw_read", iterations);
+
+    // The generic timer counter when built with RT_TIME_COUNTER on aarch64, the raw clock otherwise
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        acc = 0;
+        for(int k = 0; k < OPS_PER_SAMPLE; k++) acc += rt_stopwatch();
+        latency_histogram_record(&hist, rt_now() - t0);
+        sink = acc;
+    }
+    report("stopwatch_read", iterations);
+
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        acc = 0;
+        for(int k = 0; k < OPS_PER_SAMPLE; k++)
+        {
+            ns_to_timespec(t0 + k * 8333333ULL, &ts);
+            clobber();
+            acc += timespec_to_ns(&ts);
+        }
+        latency_histogram_record(&hist, rt_now() - t0);
+        sink = acc;
+    }
+    report("timespec_round_trip", iterations);
+
+    latency_histogram_init(&hist);
+    latency_histogram_init(&target);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        for(int k = 0; k < OPS_PER_SAMPLE; k++)
+        {
+            latency_histogram_record(&target, (uint64_t)k * 997);
+            clobber();
+        }
+        latency_histogram_record(&hist, rt_now() - t0);
+    }
+    report("latency_histogram_record", iterations);
+
+    latency_histogram_init(&hist);
+    jitter_stats_init(&jitter);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        for(int k = 0; k < OPS_PER_SAMPLE; k++)
+        {
+            jitter_stats_record(&jitter, (int64_t)k * 97 - 20000);
+            clobber();
+        }
+        latency_histogram_record(&hist, rt_now() - t0);
+    }
+    report("jitter_stats_record", iterations);
+
+    // One ping and one stop decision per call, closing at 400 mm/s with every 16th echo spurious
+    range_filter_init(&range_filter, 166666667ULL);
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        acc = 0;
+        for(int k = 0; k < OPS_PER_SAMPLE; k++)
+        {
+            uint64_t ping_ns = ((uint64_t)i * OPS_PER_SAMPLE + k) * 166666667ULL;
+            int32_t distance_mm = ((k & 15) == 15) ? 90 : 4000 - (k * 67) % 3500 + (k & 7);
+
+            range_filter_update(&range_filter, distance_mm, ping_ns);
+            range_filter_decide(&range_filter, ping_ns + 1000000, 70, 400, 0.08, &decision);
+            acc += decision.stop;
+        }
+        latency_histogram_record(&hist, rt_now() - t0);
+        sink = acc;
+    }
+    report("range_filter_update_decide", iterations);
+
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        for(int k = 0; k < OPS_PER_SAMPLE; k++)
+        {
+            blackboard_set_front(k, false, t0);
+            clobber();
+        }
+        latency_histogram_record(&hist, rt_now() - t0);
+    }
+    report("blackboard_set_front", iterations);
+
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        acc = 0;
+        for(int k = 0; k < OPS_PER_SAMPLE; k++)
+        {
+            blackboard_snapshot(&snap);
+            acc += snap.front.distance_mm;
+        }
+        latency_histogram_record(&hist, rt_now() - t0);
+        sink = acc;
+    }
+    report("blackboard_snapshot", iterations);
+
+    // No drainer runs, so the ring fills and the rest measures the drop path
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        for(int k = 0; k < OPS_PER_SAMPLE; k++) trace_emit(SERVICE_MOTOR, TRACE_EV_SERVICE, k, 0, t0, t0);
+        latency_histogram_record(&hist, rt_now() - t0);
+    }
+    report("trace_emit_full_ring", iterations);
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    bench_gpio.cpp
+ * @brief   This file contains the micro-benchmark of batched against per-pin direction updates on the GPIO registers
+ * @date    18th October 2026
+ *
+ * Usage: bench_gpio [iterations] [--hw]
+ * Runs on the fake register file unless --hw maps /dev/gpiomem (do not run --hw
+ * with the motor driver powered). Prints one JSON object per variant with the
+ * mean and p99 cost of updating the four direction pins of both motors.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gpio_mmio.h"
+#include "latency_histogram.h"
+#include "service_stats.h"
+
+#define OPS_PER_SAMPLE (1000)   // one sample times this many updates to rise above the clock read cost
+
+static const int in1_bcm[2] = { 23, 22 };
+static const int in2_bcm[2] = { 24, 27 };
+
+static latency_histogram_t hist;
+
+static void report(const char *name, int iterations)
+{
+    printf("{\"bench\":\"%s\",\"iterations\":%d,\"mean_ns\":%.1f,\"p99_ns\":%.1f,\"max_ns\":%.1f}\n",
+           name, iterations * OPS_PER_SAMPLE, hist.sum_ns.load() / (double)hist.count.load() / OPS_PER_SAMPLE,
+           latency_histogram_percentile(&hist, 99.0) / (double)OPS_PER_SAMPLE, hist.max_ns.load() / (double)OPS_PER_SAMPLE);
+}
+
+static void masks_for(int direction, uint32_t *set_mask, uint32_t *clr_mask)
+{
+    *set_mask = *clr_mask = 0;
+    for(int m = 0; m < 2; m++)
+    {
+        *(direction ? set_mask : clr_mask) |= GPIO_MMIO_BIT(in1_bcm[m]);
+        *(direction ? clr_mask : set_mask) |= GPIO_MMIO_BIT(in2_bcm[m]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = ((argc > 1) && (argv[1][0] != '-')) ? atoi(argv[1]) : 1000;
+    bool hw = (argc > 1) && (strcmp(argv[argc - 1], "--hw") == 0);
+    gpio_mmio_t gpio;
+    uint32_t set_mask[2], clr_mask[2];
+    uint64_t t0;
+
+    if((hw ? gpio_mmio_open(&gpio) : gpio_mmio_open_fake(&gpio)) < 0) return -1;
+    for(int m = 0; m < 2; m++)
+    {
+        gpio_mmio_set_output(&gpio, in1_bcm[m]);
+        gpio_mmio_set_output(&gpio, in2_bcm[m]);
+    }
+    masks_for(0, &set_mask[0], &clr_mask[0]);
+    masks_for(1, &set_mask[1], &clr_mask[1]);
+
+    // Per pin: one store per direction pin, the way four digitalWrite calls land
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        for(int k = 0; k < OPS_PER_SAMPLE; k++)
+        {
+            int d = k & 1;
+            for(int m = 0; m < 2; m++)
+            {
+                gpio_mmio_write(&gpio, d ? GPIO_MMIO_BIT(in1_bcm[m]) : 0, d ? 0 : GPIO_MMIO_BIT(in1_bcm[m]));
+                gpio_mmio_write(&gpio, d ? 0 : GPIO_MMIO_BIT(in2_bcm[m]), d ? GPIO_MMIO_BIT(in2_bcm[m]) : 0);
+            }
+        }
+        latency_histogram_record(&hist, rt_now() - t0);
+    }
+    report(hw ? "gpio_per_pin_hw" : "gpio_per_pin_fake", iterations);
+
+    // Batched: one clear and one set for both motors
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        t0 = rt_now();
+        for(int k = 0; k < OPS_PER_SAMPLE; k++)
+            gpio_mmio_write(&gpio, set_mask[k & 1], clr_mask[k & 1]);
+        latency_histogram_record(&hist, rt_now() - t0);
+    }
+    report(hw ? "gpio_batched_hw" : "gpio_batched_fake", iterations);
+
+    // The last update was forward, IN1 high and IN2 low on both motors
+    if(!hw && ((gpio_mmio_levels(&gpio) & (clr_mask[1] | set_mask[1])) != set_mask[1]))
+    {
+        printf("{\"bench\":\"gpio_levels\",\"error\":\"unexpected levels 0x%08x\"}\n", gpio_mmio_levels(&gpio));
+        return -1;
+    }
+
+    gpio_mmio_close(&gpio);
+    return 0;
+}
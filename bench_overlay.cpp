@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    bench_overlay.cpp
+ * @brief   This file contains the micro-benchmark of the overlay compositor against per-frame cv::line/putText
+ * @date    18th October 2026
+ *
+ * Usage: bench_overlay [iterations]
+ * Prints one JSON object per variant with the mean and p99 cost per 640x480 frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <opencv2/core/core.hpp>
+
+#include "overlay.h"
+#include "latency_histogram.h"
+#include "service_stats.h"
+#include "blackboard.h"
+#include "ultrasonic_sensor.h"
+
+using namespace cv;
+
+static latency_histogram_t hist;
+
+static void report(const char *name, int iterations)
+{
+    printf("{\"bench\":\"%s\",\"iterations\":%d,\"mean_ns\":%.0f,\"p99_ns\":%llu,\"max_ns\":%llu}\n",
+           name, iterations, hist.sum_ns.load() / (double)hist.count.load(),
+           (unsigned long long)latency_histogram_percentile(&hist, 99.0), (unsigned long long)hist.max_ns.load());
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = (argc > 1) ? atoi(argv[1]) : 1000;
+    Size size(640, 480);
+    Mat source(size, CV_8UC3, Scalar(90, 110, 130));
+    Mat frame(size, CV_8UC3);
+    pipeline_frame_t pframe;
+    overlay_t overlay;
+    ultrasonic_ranges_t ranges;
+    uint64_t t0;
+
+    blackboard_init();
+    overlay_init(&overlay, size);
+
+    // Only the rear sensor is fitted, the overlay shows its range
+    memset(&ranges, 0, sizeof(ranges));
+    for(int i = 0; i < BLACKBOARD_MAX_RANGES; i++)
+        ranges.distance_mm[i] = -1;
+    ranges.fitted_mask = 1u << ULTRASONIC_REAR;
+
+    // Naive: draw every line and the text into every frame
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        source.copyTo(frame);
+        t0 = rt_now();
+        overlay_draw_naive(frame, 1234 + (i / 15), OVERLAY_STATUS_CLEAR);
+        latency_histogram_record(&hist, rt_now() - t0);
+    }
+    report("overlay_naive_640x480", iterations);
+
+    // Compositor: precomputed guide layer, text re-rendered when the distance changes (every 15 frames here)
+    latency_histogram_init(&hist);
+    pframe.image = frame;
+    for(int i = 0; i < iterations; i++)
+    {
+        source.copyTo(frame);
+        ranges.distance_mm[ULTRASONIC_REAR] = 1234 + (i / 15);
+        ranges.measured_ns[ULTRASONIC_REAR] = rt_now();
+        blackboard_set_ranges(&ranges);
+        t0 = rt_now();
+        overlay_stage(&pframe, &overlay);
+        latency_histogram_record(&hist, rt_now() - t0);
+    }
+    report("overlay_composite_640x480", iterations);
+
+    // Blend kernel alone with the text unchanged
+    latency_histogram_init(&hist);
+    for(int i = 0; i < iterations; i++)
+    {
+        source.copyTo(frame);
+        t0 = rt_now();
+        overlay_blend(frame, &overlay.guides);
+        overlay_blend(frame, &overlay.text);
+        latency_histogram_record(&hist, rt_now() - t0);
+    }
+    report("overlay_blend_only_640x480", iterations);
+
+    return 0;
+}
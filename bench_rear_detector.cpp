@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    bench_rear_detector.cpp
+ * @brief   This file contains the benchmark of the rear obstacle detector on recorded clips
+ * @date    18th October 2026
+ *
+ * Usage: bench_rear_detector <clip> [onset_frame]
+ * onset_frame is the first frame in which the obstacle should count as present,
+ * the detection latency is measured from there. Prints one JSON object.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "rear_detector.h"
+#include "latency_histogram.h"
+#include "service_stats.h"
+
+using namespace cv;
+
+// The detector runs standalone here, the stop hook into the motor service is not linked
+void motor_emergency_stop(event_latency_id_t, uint64_t) {}
+
+static latency_histogram_t hist;
+
+int main(int argc, char *argv[])
+{
+    VideoCapture clip;
+    Mat raw, frame(Size(640, 480), CV_8UC3);
+    rear_detector_t det;
+    long onset = -1, first_detect = -1, frames = 0;
+    double fps;
+    uint64_t t0;
+
+    if(argc < 2)
+    {
+        printf("Usage: %s <clip> [onset_frame]\n", argv[0]);
+        exit(-1);
+    }
+    if(argc > 2) onset = atol(argv[2]);
+
+    if(!clip.open(argv[1]))
+    {
+        printf("Cannot open %s\n", argv[1]);
+        exit(-1);
+    }
+    fps = clip.get(CAP_PROP_FPS);
+    if(fps <= 0.0) fps = 15.0;
+
+    rear_detector_init(&det, frame.size());
+    latency_histogram_init(&hist);
+
+    while(clip.read(raw))
+    {
+        // Clips are brought to the camera resolution outside the timed region
+        if(raw.size() != frame.size())
+            resize(raw, frame, frame.size());
+        else
+            raw.copyTo(frame);
+
+        t0 = rt_now();
+        bool obstacle = rear_detector_process(&det, frame);
+        latency_histogram_record(&hist, rt_now() - t0);
+
+        if(obstacle && (first_detect < 0) && (frames >= onset)) first_detect = frames;
+        frames++;
+    }
+
+    printf("{\"bench\":\"rear_detector_640x480\",\"clip\":\"%s\",\"frames\":%ld,\"mean_ns\":%.0f,\"p99_ns\":%llu,\"max_ns\":%llu,"
+           "\"onset_frame\":%ld,\"detect_frame\":%ld,\"detect_latency_ms\":%.1f}\n",
+           argv[1], frames, hist.count.load() ? hist.sum_ns.load() / (double)hist.count.load() : 0.0,
+           (unsigned long long)latency_histogram_percentile(&hist, 99.0), (unsigned long long)hist.max_ns.load(),
+           onset, first_detect, ((onset >= 0) && (first_detect >= 0)) ? (first_detect - onset) * 1000.0 / fps : -1.0);
+
+    return 0;
+}
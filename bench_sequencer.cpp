@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    bench_sequencer.cpp
+ * @brief   This file contains the release jitter benchmark of the absolute time sequencer loop
+ * @date    18th October 2026
+ *
+ * Usage: bench_sequencer [cycles] [--fifo]
+ * Sleeps to absolute release times at the sequencer rate, the way main's
+ * sequencer does, and records wakeup minus release time. --fifo runs at the
+ * top SCHED_FIFO priority, which needs root. The default 1200 cycles take
+ * 10 seconds. Prints one JSON object.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+
+#include "latency_histogram.h"
+#include "service_stats.h"
+#include "service.h"
+#include "rt_time.h"
+
+static latency_histogram_t hist;
+
+int main(int argc, char *argv[])
+{
+    int cycles = ((argc > 1) && (argv[1][0] != '-')) ? atoi(argv[1]) : 10 * SEQUENCER_FREQ_HZ;
+    bool fifo = (argc > 1) && (strcmp(argv[argc - 1], "--fifo") == 0);
+    struct sched_param param;
+    struct timespec release_time;
+    uint64_t start_ns, release_ns, wake_ns;
+    int rc;
+
+    if(fifo)
+    {
+        param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+        if(sched_setscheduler(0, SCHED_FIFO, &param) != 0)
+        {
+            printf("{\"bench\":\"sequencer_release_jitter\",\"error\":\"SCHED_FIFO refused: %s\"}\n", strerror(errno));
+            return -1;
+        }
+    }
+
+    latency_histogram_init(&hist);
+    start_ns = rt_now();
+    for(int seq = 1; seq <= cycles; seq++)
+    {
+        release_ns = start_ns + ((uint64_t)seq * NSEC_PER_SEC) / SEQUENCER_FREQ_HZ;
+        ns_to_timespec(release_ns, &release_time);
+        do
+        {
+            rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &release_time, NULL);
+        } while(rc == EINTR);
+
+        wake_ns = rt_now();
+        latency_histogram_record(&hist, wake_ns - release_ns);
+    }
+
+    printf("{\"bench\":\"sequencer_release_jitter%s\",\"cycles\":%d,\"mean_ns\":%.0f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p99_9_ns\":%llu,\"max_ns\":%llu}\n",
+           fifo ? "_fifo" : "", cycles, hist.sum_ns.load() / (double)hist.count.load(),
+           (unsigned long long)latency_histogram_percentile(&hist, 50.0), (unsigned long long)latency_histogram_percentile(&hist, 99.0),
+           (unsigned long long)latency_histogram_percentile(&hist, 99.9), (unsigned long long)hist.max_ns.load());
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    blackboard.cpp
+ * @brief   This file contains definition of the shared vehicle state blackboard
+ * @date    18th October 2026
+ *
+ */
+
+#include "blackboard.h"
+
+// Every section sits on its own cache line so writers on different cores never share one
+static seqlock_t<gear_state_t> gear_section;
+static seqlock_t<front_range_t> front_section;
+static seqlock_t<rear_range_t> rear_section;
+static seqlock_t<ultrasonic_ranges_t> ranges_section;
+alignas(BLACKBOARD_CACHE_LINE) static std::atomic<bool> shutdown_requested;
+
+static_assert(ATOMIC_BOOL_LOCK_FREE == 2, "shutdown flag must be safe to set from a signal handler");
+
+void blackboard_init(void)
+{
+    gear_state_t gear = { GEAR_FORWARD, 0 };
+    front_range_t front = { -1, false, 0 };
+    rear_range_t rear = { false, 0 };
+    ultrasonic_ranges_t ranges;
+
+    for(int i = 0; i < BLACKBOARD_MAX_RANGES; i++)
+    {
+        ranges.distance_mm[i] = -1;
+        ranges.measured_ns[i] = 0;
+    }
+    ranges.fitted_mask = 0;
+    ranges.rear_obstacle = false;
+
+    gear_section.seq.store(0, std::memory_order_relaxed);
+    front_section.seq.store(0, std::memory_order_relaxed);
+    rear_section.seq.store(0, std::memory_order_relaxed);
+    ranges_section.seq.store(0, std::memory_order_relaxed);
+    gear_section.write(gear);
+    front_section.write(front);
+    rear_section.write(rear);
+    ranges_section.write(ranges);
+    shutdown_requested.store(false, std::memory_order_relaxed);
+}
+
+void blackboard_set_gear(gear_t gear, uint64_t changed_ns)
+{
+    gear_state_t state = { gear, changed_ns };
+
+    gear_section.write(state);
+}
+
+void blackboard_set_front(int32_t distance_mm, bool obstacle, uint64_t measured_ns)
+{
+    front_range_t state = { distance_mm, obstacle, measured_ns };
+
+    front_section.write(state);
+}
+
+void blackboard_set_ranges(const ultrasonic_ranges_t *ranges)
+{
+    ranges_section.write(*ranges);
+}
+
+void blackboard_set_rear(bool obstacle, uint64_t measured_ns)
+{
+    rear_range_t state = { obstacle, measured_ns };
+
+    rear_section.write(state);
+}
+
+gear_t blackboard_gear(void)
+{
+    gear_state_t state;
+
+    gear_section.read(&state);
+    return state.gear;
+}
+
+void blackboard_snapshot(vehicle_snapshot_t *snap)
+{
+    snap->gear_version = gear_section.read(&snap->gear);
+    snap->front_version = front_section.read(&snap->front);
+    snap->rear_version = rear_section.read(&snap->rear);
+    snap->ranges_version = ranges_section.read(&snap->ranges);
+    snap->shutdown = shutdown_requested.load(std::memory_order_acquire);
+}
+
+bool blackboard_obstacle_in_path(const vehicle_snapshot_t *snap)
+{
+    // Forward only the ultrasonic sensors look ahead, backward the camera and any rear facing sensor
+    return (snap->gear.gear == GEAR_FORWARD) ? snap->front.obstacle : (snap->rear.obstacle || snap->ranges.rear_obstacle);
+}
+
+void blackboard_request_shutdown(void)
+{
+    shutdown_requested.store(true, std::memory_order_release);
+}
+
+bool blackboard_shutdown_requested(void)
+{
+    return shutdown_requested.load(std::memory_order_acquire);
+}
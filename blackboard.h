@@ -0,0 +1,176 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    blackboard.h
+ * @brief   This file contains declaration of the shared vehicle state blackboard
+ * @date    18th October 2026
+ *
+ */
+
+#ifndef _BLACKBOARD_H
+#define _BLACKBOARD_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#define BLACKBOARD_CACHE_LINE (64)
+#define BLACKBOARD_MAX_RANGES (4)      // ultrasonic sensors of the array
+
+typedef enum
+{
+    GEAR_FORWARD = 0,
+    GEAR_REVERSE
+} gear_t;
+
+// Written by motor_service only
+typedef struct
+{
+    gear_t gear;
+    uint64_t changed_ns;        // time of the last gear change, 0 at startup
+} gear_state_t;
+
+// Written by the ultrasonic service only, all the forward facing sensors together
+typedef struct
+{
+    int32_t distance_mm;        // -1 when nothing is in range or the sensor is idle
+    bool obstacle;              // distance below the stop threshold
+    uint64_t measured_ns;       // echo end of the reading, 0 until the first one
+} front_range_t;
+
+// Written by the ultrasonic service only, the filtered range of every sensor of the array
+typedef struct
+{
+    int32_t distance_mm[BLACKBOARD_MAX_RANGES];   // -1 when nothing is in range, the sensor is idle or not fitted
+    uint64_t measured_ns[BLACKBOARD_MAX_RANGES];  // last accepted ping, 0 until the first one
+    uint32_t fitted_mask;                         // bit per sensor the vehicle has
+    bool rear_obstacle;                           // a rear facing sensor asks to stop
+} ultrasonic_ranges_t;
+
+// Written by the rear detector stage on the camera thread only
+typedef struct
+{
+    bool obstacle;
+    uint64_t measured_ns;       // capture time of the frame the decision was made on
+} rear_range_t;
+
+/*
+ * Single writer seqlock, the writer never waits and readers retry while a write
+ * is in progress. The payload is kept in atomic words so a racing read is never
+ * undefined behaviour, only discarded.
+ */
+template <typename T>
+struct alignas(BLACKBOARD_CACHE_LINE) seqlock_t
+{
+    static const int WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> seq;
+    std::atomic<uint64_t> words[WORDS];
+
+    void write(const T &value)
+    {
+        uint64_t buf[WORDS] = {0};
+        uint32_t s = seq.load(std::memory_order_relaxed);
+
+        memcpy(buf, &value, sizeof(T));
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for(int i = 0; i < WORDS; i++)
+            words[i].store(buf[i], std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // Returns the number of writes the snapshot reflects
+    uint32_t read(T *value) const
+    {
+        uint64_t buf[WORDS];
+        uint32_t s0, s1;
+
+        for(;;)
+        {
+            s0 = seq.load(std::memory_order_acquire);
+            if(s0 & 1) continue;
+            for(int i = 0; i < WORDS; i++)
+                buf[i] = words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s1 = seq.load(std::memory_order_relaxed);
+            if(s0 == s1) break;
+        }
+        memcpy(value, buf, sizeof(T));
+        return s0 / 2;
+    }
+};
+
+// Consistent copy of the whole blackboard, each section carries its own version
+typedef struct
+{
+    gear_state_t gear;
+    front_range_t front;
+    rear_range_t rear;
+    ultrasonic_ranges_t ranges;
+    uint32_t gear_version;
+    uint32_t front_version;
+    uint32_t rear_version;
+    uint32_t ranges_version;
+    bool shutdown;
+} vehicle_snapshot_t;
+
+/*
+ * @brief Function to reset the blackboard to forward gear with no readings
+ */
+void blackboard_init(void);
+
+/*
+ * @brief Function to publish a gear change, motor_service only
+ */
+void blackboard_set_gear(gear_t gear, uint64_t changed_ns);
+
+/*
+ * @brief Function to publish an ultrasonic reading, the ultrasonic service only
+ */
+void blackboard_set_front(int32_t distance_mm, bool obstacle, uint64_t measured_ns);
+
+/*
+ * @brief Function to publish the ranges of all the ultrasonic sensors, the ultrasonic service only
+ */
+void blackboard_set_ranges(const ultrasonic_ranges_t *ranges);
+
+/*
+ * @brief Function to publish a rear detector decision, camera thread only
+ */
+void blackboard_set_rear(bool obstacle, uint64_t measured_ns);
+
+/*
+ * @brief Function to read the current gear without taking a full snapshot
+ */
+gear_t blackboard_gear(void);
+
+/*
+ * @brief Function to read all the sections, each one is internally consistent
+ */
+void blackboard_snapshot(vehicle_snapshot_t *snap);
+
+/*
+ * @brief Function to check whether the obstacle sensor for the current gear asks to stop
+ */
+bool blackboard_obstacle_in_path(const vehicle_snapshot_t *snap);
+
+/*
+ * @brief Function to request all the services to stop, async signal safe
+ */
+void blackboard_request_shutdown(void);
+
+/*
+ * @brief Function to check whether a shutdown was requested
+ */
+bool blackboard_shutdown_requested(void);
+
+#endif
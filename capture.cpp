@@ -25,80 +25,401 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
+#include <vector>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
 
 #include <syslog.h>
 #include <semaphore.h>
 #include <pthread.h>
+#include <atomic>
 
 #include "capture.h"
 #include "motor.h"
-#include "time_stamp.h"
+#include "rt_time.h"
+#include "service_stats.h"
+#include "trace.h"
+#include "v4l2_capture.h"
+#include "frame_pipeline.h"
+#include "overlay.h"
+#include "rear_detector.h"
+#include "blackboard.h"
+#include "service.h"
+#include "record.h"
+#include "rt_memory.h"
 
 using namespace cv;
 using namespace std;
 
-extern bool is_forward;
-extern bool is_reverse;
-extern bool abortS1;
-
 #define SYSTEM_ERROR (-1)
+#define FRAME_WIDTH (640)
+#define FRAME_HEIGHT (480)
+#define V4L2_DEQUEUE_TIMEOUT_MS (100)
+#define STANDBY_FLUSH_DIVISOR (4)      // standby keeps the stream moving at 15/4 Hz
+#define SIM_FRAME_GRAY (96)            // level of the simulated frames
+
+/*
+ * While moving forward the stream stays open with buffers cycling through the
+ * driver (standby), so switching to reverse only has to skip stale buffers
+ * instead of starting a cold stream.
+ */
+typedef enum
+{
+    CAMERA_STANDBY = 0,
+    CAMERA_ACTIVE
+} camera_state_t;
+
+static std::atomic<uint64_t> gear_change_ns(0);
+static overlay_t overlay;
+static rear_detector_t rear_detector;
+
+static camera_backend_t camera_backend = CAMERA_BACKEND_OPENCV;
+static const char *camera_device = "/dev/video0";
+static uint32_t camera_pixfmt = V4L2_PIX_FMT_YUYV;
+static unsigned camera_num_buffers = 4;
+
+void camera_gear_changed(uint64_t changed_ns)
+{
+    gear_change_ns.store(changed_ns, std::memory_order_relaxed);
+
+    // Extra release so the state change does not wait for the next 15 Hz slot
+    service_wake(SERVICE_CAMERA);
+}
+
+void setup_camera(camera_backend_t backend, const char *device, uint32_t pixfmt, unsigned num_buffers)
+{
+    camera_backend = backend;
+    if(device) camera_device = device;
+    camera_pixfmt = pixfmt;
+    camera_num_buffers = num_buffers;
+}
+
+/*
+ * Convert a YUYV, MJPEG or BGR buffer into the BGR pipeline frame. Rows above
+ * first_row keep what the slot held before, only MJPEG is always decoded whole.
+ */
+static void camera_decode(uint32_t pixfmt, int width, int height, int stride, const uint8_t *data, size_t size, Mat &frame,
+                          int first_row)
+{
+    if((first_row > 0) && ((frame.cols != width) || (frame.rows != height) || (frame.type() != CV_8UC3)))
+        first_row = 0;
 
-sem_t sem_camera;
+    if(pixfmt == V4L2_PIX_FMT_YUYV)
+    {
+        Mat yuyv(height, width, CV_8UC2, (void *)data, stride);
+        if(first_row > 0)
+        {
+            Mat rows = frame.rowRange(first_row, height);
+            cvtColor(yuyv.rowRange(first_row, height), rows, COLOR_YUV2BGR_YUYV);
+        }
+        else cvtColor(yuyv, frame, COLOR_YUV2BGR_YUYV);
+    }
+    else if(pixfmt == V4L2_PIX_FMT_BGR24)
+    {
+        Mat bgr(height, width, CV_8UC3, (void *)data, stride);
+        if(first_row > 0)
+        {
+            Mat rows = frame.rowRange(first_row, height);
+            bgr.rowRange(first_row, height).copyTo(rows);
+        }
+        else bgr.copyTo(frame);
+    }
+    else
+    {
+        Mat jpeg(1, (int)size, CV_8UC1, (void *)data);
+        imdecode(jpeg, IMREAD_COLOR, &frame);
+    }
+}
+
+static void camera_record_frame(uint32_t pixfmt, int width, int height, int stride, const uint8_t *data, size_t size, uint64_t capture_ns)
+{
+    record_frame_t info = { pixfmt, (uint16_t)width, (uint16_t)height, (uint32_t)stride, (uint32_t)size };
+
+    record_append(RECORD_STREAM_FRAME, 0, capture_ns, &info, sizeof(info), data, (uint32_t)size);
+}
 
-void *camera_service(void *threadp)
+// A frame the degrade policy keeps off the display is only decoded where the detector looks
+static int camera_first_row(void)
+{
+    return frame_pipeline_presents_next() ? 0 : rear_detector.roi.y;
+}
+
+/*
+ * Dequeue the newest filled driver buffer and convert it into the BGR pipeline
+ * frame. The driver buffer is only read in place, older filled buffers are
+ * handed straight back so the view is never more than one frame stale. Frames
+ * captured before min_capture_ns are skipped as well.
+ */
+static bool camera_read_v4l2(v4l2_capture_t *cap, Mat &frame, uint64_t *capture_ns, uint64_t min_capture_ns)
+{
+    v4l2_frame_t vf, newer;
+
+    if(v4l2_capture_dequeue(cap, &vf, V4L2_DEQUEUE_TIMEOUT_MS) != 1)
+        return false;
+
+    for(;;)
+    {
+        while(v4l2_capture_dequeue(cap, &newer, 0) == 1)
+        {
+            v4l2_capture_requeue(cap, &vf);
+            vf = newer;
+        }
+
+        if(vf.timestamp_ns >= min_capture_ns)
+            break;
+
+        v4l2_capture_requeue(cap, &vf);
+        if(v4l2_capture_dequeue(cap, &vf, V4L2_DEQUEUE_TIMEOUT_MS) != 1)
+            return false;
+    }
+
+    service_stats_event_latency(EVENT_FRAME_AGE, vf.timestamp_ns);
+    *capture_ns = vf.timestamp_ns;
+
+    // The driver buffer as is, MJPEG keeps the recording compact
+    camera_record_frame(vf.pixfmt, vf.width, vf.height, vf.stride, vf.data, vf.size, vf.timestamp_ns);
+    camera_decode(vf.pixfmt, vf.width, vf.height, vf.stride, vf.data, vf.size, frame, camera_first_row());
+
+    v4l2_capture_requeue(cap, &vf);
+    return !frame.empty();
+}
+
+/*
+ * Take the newest recorded frame that is due on the replay timeline. Nothing new
+ * since the last one reads as no frame, like a camera that did not deliver.
+ */
+static size_t replay_next_frame = 0;
+
+static bool camera_read_replay(Mat &frame, uint64_t *capture_ns, uint64_t min_capture_ns)
+{
+    const record_reader_t *rec = replay_reader();
+    size_t count = record_reader_count(rec, RECORD_STREAM_FRAME);
+    uint64_t now = replay_now();
+    const record_header_t *entry = NULL;
+    const record_frame_t *info;
+
+    while((replay_next_frame < count) && (record_reader_entry(rec, RECORD_STREAM_FRAME, replay_next_frame)->timestamp_ns <= now))
+        entry = record_reader_entry(rec, RECORD_STREAM_FRAME, replay_next_frame++);
+
+    if(!entry) return false;
+
+    *capture_ns = replay_to_local(entry->timestamp_ns);
+    if(*capture_ns < min_capture_ns) return false;
+
+    service_stats_event_latency(EVENT_FRAME_AGE, *capture_ns);
+    info = (const record_frame_t *)record_payload(entry);
+    camera_decode(info->pixfmt, info->width, info->height, info->stride, (const uint8_t *)(info + 1), info->size, frame,
+                  camera_first_row());
+    return !frame.empty();
+}
+
+// Give every filled buffer back to the driver without looking at it
+static void camera_standby_flush(v4l2_capture_t *cap, VideoCapture &cam0)
+{
+    v4l2_frame_t vf;
+
+    if(camera_backend == CAMERA_BACKEND_V4L2)
+    {
+        while(v4l2_capture_dequeue(cap, &vf, 0) == 1)
+            v4l2_capture_requeue(cap, &vf);
+    }
+    else if(camera_backend == CAMERA_BACKEND_OPENCV)
+    {
+        cam0.grab();
+    }
+}
+
+static VideoCapture cam0;
+static v4l2_capture_t v4l2_cam;
+static camera_state_t state = CAMERA_STANDBY;
+static unsigned long standby_count = 0;
+static uint64_t activate_ns = 0;
+static bool awaiting_first_frame = false;
+
+/*
+ * The camera sits in standby until the first reverse, long after the service is
+ * guarded. Decode the format it will see and run every stage once on a blank
+ * frame now, so their first use allocations happen before the guard.
+ */
+static void camera_warmup(void)
+{
+    pipeline_frame_t *slot = frame_pipeline_back();
+    const record_reader_t *rec;
+    const record_frame_t *info;
+    uint32_t pixfmt = V4L2_PIX_FMT_BGR24;
+
+    if (camera_backend == CAMERA_BACKEND_V4L2)
+    {
+        pixfmt = camera_pixfmt;
+    }
+    else if ((camera_backend == CAMERA_BACKEND_REPLAY) &&
+             (record_reader_count((rec = replay_reader()), RECORD_STREAM_FRAME) > 0))
+    {
+        info = (const record_frame_t *)record_payload(record_reader_entry(rec, RECORD_STREAM_FRAME, 0));
+        pixfmt = info->pixfmt;
+        if (pixfmt != V4L2_PIX_FMT_MJPEG)
+            camera_decode(info->pixfmt, info->width, info->height, info->stride, (const uint8_t *)(info + 1), info->size, slot->image, 0);
+    }
+    else if (camera_backend == CAMERA_BACKEND_OPENCV)
+    {
+        cam0.read(slot->image);
+    }
+
+    // imdecode sets up a new decoder and libjpeg pools on every frame
+    if (pixfmt == V4L2_PIX_FMT_MJPEG)
+    {
+        if (rt_memory_strict())
+        {
+            printf("MJPEG frames are not decoded allocation free, -M needs YUYV frames\r\n");
+            exit(SYSTEM_ERROR);
+        }
+        printf("MJPEG decoding allocates on every frame, the camera allocations are counted\r\n");
+    }
+    else if (pixfmt == V4L2_PIX_FMT_YUYV)
+    {
+        std::vector<uint8_t> blank(FRAME_WIDTH * FRAME_HEIGHT * 2, 128);
+        camera_decode(pixfmt, FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH * 2, blank.data(), blank.size(), slot->image, 0);
+    }
+
+    rear_detector_process(&rear_detector, slot->image);
+    rear_detector_reset(&rear_detector);
+    overlay_stage(slot, &overlay);
+    slot->image.setTo(Scalar(0, 0, 0));
+}
+
+void camera_init(void)
 {
-    struct timespec start = {0,0};
-    struct timespec stop = {0,0};
-    static struct timespec wcet = {0,0};
-    struct timespec time_taken = {0,0};
-    unsigned long camera_service_count = 0;
     printf("Camera service started\r\n");
-    VideoCapture cam0(0);
-    namedWindow("video_display");
-    char winInput;
 
-    if (!cam0.isOpened())
+    if (camera_backend == CAMERA_BACKEND_REPLAY)
+    {
+        printf("Camera frames replayed\r\n");
+    }
+    else if (camera_backend == CAMERA_BACKEND_SIM)
+    {
+        printf("Camera frames simulated\r\n");
+    }
+    else if (camera_backend == CAMERA_BACKEND_V4L2)
+    {
+        if ((v4l2_capture_open(&v4l2_cam, camera_device, FRAME_WIDTH, FRAME_HEIGHT, camera_pixfmt, camera_num_buffers) < 0) ||
+            (v4l2_capture_start(&v4l2_cam) < 0))
+        {
+            exit(SYSTEM_ERROR);
+        }
+    }
+    else
+    {
+        cam0.open(0);
+        if (!cam0.isOpened())
+        {
+            exit(SYSTEM_ERROR);
+        }
+
+        cam0.set(CAP_PROP_FRAME_WIDTH, FRAME_WIDTH);
+        cam0.set(CAP_PROP_FRAME_HEIGHT, FRAME_HEIGHT);
+        cam0.set(CAP_PROP_BUFFERSIZE, 1);   // at most one stale frame queued in standby
+    }
+
+    // Display runs in its own non-RT thread, this service only captures and processes
+    frame_pipeline_init(Size(FRAME_WIDTH, FRAME_HEIGHT), CV_8UC3);
+    overlay_init(&overlay, Size(FRAME_WIDTH, FRAME_HEIGHT));
+    rear_detector_init(&rear_detector, Size(FRAME_WIDTH, FRAME_HEIGHT));
+
+    // Detector first so the overlay already shows its decision and it sees the raw image
+    frame_pipeline_add_stage("rear_detector", rear_detector_stage, &rear_detector);
+    frame_pipeline_add_stage("overlay", overlay_stage, &overlay);
+    camera_warmup();
+    if (frame_pipeline_start_display("video_display") < 0)
     {
         exit(SYSTEM_ERROR);
     }
+}
 
-    cam0.set(CAP_PROP_FRAME_WIDTH, 640);
-    cam0.set(CAP_PROP_FRAME_HEIGHT, 480);
+void camera_release(uint64_t start_ns, uint32_t seq)
+{
+    bool is_reverse = (blackboard_gear() == GEAR_REVERSE);
 
-    Mat frame;
-    Mat blackframe = Mat::zeros(Size(640, 480), CV_8UC3);
+    if ((state == CAMERA_STANDBY) && is_reverse)
+    {
+        state = CAMERA_ACTIVE;
+        activate_ns = gear_change_ns.load(std::memory_order_relaxed);
+        if (activate_ns == 0) activate_ns = start_ns;
+        awaiting_first_frame = true;
+        rear_detector_reset(&rear_detector);     // nothing seen in an earlier reverse counts now
+        if (camera_backend == CAMERA_BACKEND_OPENCV)
+        {
+            cam0.grab();    // discard the frame queued while in standby
+        }
+        trace_emit(SERVICE_CAMERA, TRACE_EV_CAMERA_STATE, seq, state, activate_ns, start_ns);
+    }
+    else if ((state == CAMERA_ACTIVE) && !is_reverse)
+    {
+        state = CAMERA_STANDBY;
+        trace_emit(SERVICE_CAMERA, TRACE_EV_CAMERA_STATE, seq, state, start_ns, start_ns);
 
-    while (!abortS1)
+        // Blank the display once when leaving reverse
+        pipeline_frame_t *slot = frame_pipeline_back();
+        slot->image.setTo(Scalar(0, 0, 0));
+        slot->capture_ns = start_ns;
+        frame_pipeline_submit(false);
+    }
+
+    if (state == CAMERA_ACTIVE)
     {
-        sem_wait(&sem_camera);
-        if (is_reverse)
+        // Capture straight into the preallocated back slot of the pipeline
+        pipeline_frame_t *slot = frame_pipeline_back();
+        slot->capture_ns = start_ns;
+        bool have_frame;
+        if (camera_backend == CAMERA_BACKEND_V4L2)
+        {
+            have_frame = camera_read_v4l2(&v4l2_cam, slot->image, &slot->capture_ns, awaiting_first_frame ? activate_ns : 0);
+        }
+        else if (camera_backend == CAMERA_BACKEND_REPLAY)
         {
-            clock_gettime(CLOCK_REALTIME, &start);
-            cam0.read(frame);
-            imshow("video_display", frame);
-            clock_gettime( CLOCK_REALTIME, &stop);
-            delta_t(&stop, &start, &time_taken);
-            camera_service_count++;
-            if(check_wcet(&time_taken, &wcet))
+            have_frame = camera_read_replay(slot->image, &slot->capture_ns, awaiting_first_frame ? activate_ns : 0);
+        }
+        else if (camera_backend == CAMERA_BACKEND_SIM)
+        {
+            // Same size as a real frame so the detector and overlay cost about the same
+            slot->image.setTo(Scalar(SIM_FRAME_GRAY, SIM_FRAME_GRAY, SIM_FRAME_GRAY));
+            have_frame = true;
+        }
+        else
+        {
+            have_frame = cam0.read(slot->image);
+            if (have_frame && record_enabled())
             {
-                syslog(LOG_INFO, "camera wcet: %lu sec, %lu msec (%lu microsec), ((%lu nanosec))\n\n", wcet.tv_sec, (wcet.tv_nsec / NSEC_PER_MSEC), (wcet.tv_nsec / NSEC_PER_MICROSEC),wcet.tv_nsec);
+                Mat &image = slot->image;
+                camera_record_frame(V4L2_PIX_FMT_BGR24, image.cols, image.rows, (int)image.step, image.data,
+                                    image.step * image.rows, slot->capture_ns);
             }
-            syslog(LOG_CRIT, "camera_service_count = %lu , timestamp: %lu sec, %lu msec (%lu microsec), ((%lu nanosec))\n\n", camera_service_count, wcet.tv_sec, (wcet.tv_nsec / NSEC_PER_MSEC), (wcet.tv_nsec / NSEC_PER_MICROSEC),wcet.tv_nsec);
         }
-        else
+        if (have_frame)
         {
-            imshow("video_display", blackframe);
+            slot->seq = seq;
+            frame_pipeline_submit(true);
+            if (awaiting_first_frame)
+            {
+                service_stats_event_latency(EVENT_GEAR_TO_FRAME, activate_ns);
+                awaiting_first_frame = false;
+            }
         }
-        
-        winInput = waitKey(10);
-
     }
+    else if ((++standby_count % STANDBY_FLUSH_DIVISOR) == 0)
+    {
+        camera_standby_flush(&v4l2_cam, cam0);
+    }
+}
 
-    destroyWindow("video_display");
+void camera_fini(void)
+{
+    frame_pipeline_stop_display();
+    if (camera_backend == CAMERA_BACKEND_V4L2)
+    {
+        v4l2_capture_close(&v4l2_cam);
+    }
     printf("Camera service stopped\n");
-    pthread_exit(NULL);
 }
-
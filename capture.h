@@ -23,11 +23,37 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-extern sem_t sem_camera;
+typedef enum
+{
+    CAMERA_BACKEND_OPENCV = 0,   // cv::VideoCapture on camera 0
+    CAMERA_BACKEND_V4L2,         // native V4L2 mmap streaming, see v4l2_capture.h
+    CAMERA_BACKEND_REPLAY,       // frames of the recording given to replay_open, see record.h
+    CAMERA_BACKEND_SIM           // flat synthetic frames, no device, for the simulated vehicle
+} camera_backend_t;
 
 /**
- * @brief Camera service to display the black screen/camera feed on the display
+ * @brief Select the capture backend, must be called before the camera service starts
  */
-void *camera_service(void *threadp); 				
+void setup_camera(camera_backend_t backend, const char *device, uint32_t pixfmt, unsigned num_buffers);
+
+/**
+ * @brief Notify the camera of a gear change so it leaves or enters standby right away
+ */
+void camera_gear_changed(uint64_t changed_ns);
+
+/**
+ * @brief Open the camera and start the frame pipeline, runs on the camera service thread
+ */
+void camera_init(void);
+
+/**
+ * @brief One camera service release, captures and processes a frame in reverse, keeps the stream warm in standby
+ */
+void camera_release(uint64_t start_ns, uint32_t seq);
+
+/**
+ * @brief Stop the display and close the camera
+ */
+void camera_fini(void);
 
 #endif
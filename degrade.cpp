@@ -0,0 +1,101 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    degrade.cpp
+ * @brief   This file contains definition of the load shedding policy driven by missed deadlines
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdint.h>
+#include <atomic>
+
+#include "degrade.h"
+#include "service.h"
+#include "service_stats.h"
+#include "frame_pipeline.h"
+
+#define DEGRADE_RECOVER_WINDOWS (5)   // clean windows in a row before stepping back up
+
+static const char *degrade_mode_names[NUM_DEGRADE_MODES] = { "full", "no overlay", "display 1/2 rate", "display 1/4 rate" };
+
+static std::atomic<int> mode(DEGRADE_NONE);
+static std::atomic<uint64_t> mode_entered[NUM_DEGRADE_MODES];
+static uint64_t last_faults = 0;      // sequencer thread only
+static int clean_windows = 0;
+
+static uint64_t total_faults(void)
+{
+    uint64_t faults = 0;
+
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        faults += service_stats[i].overruns.load(std::memory_order_relaxed);
+        faults += service_stats[i].deadline_misses.load(std::memory_order_relaxed);
+    }
+    return faults;
+}
+
+static void degrade_apply(degrade_mode_t next)
+{
+    frame_pipeline_enable_stage("overlay", next < DEGRADE_NO_OVERLAY);
+    frame_pipeline_set_present_shift((next >= DEGRADE_DISPLAY_HALF) ? (next - DEGRADE_DISPLAY_HALF + 1) : 0);
+
+    mode.store(next, std::memory_order_relaxed);
+    mode_entered[next].fetch_add(1, std::memory_order_relaxed);
+}
+
+void degrade_init(void)
+{
+    for(int i = 0; i < NUM_DEGRADE_MODES; i++)
+        mode_entered[i].store(0, std::memory_order_relaxed);
+    last_faults = total_faults();
+    clean_windows = 0;
+    degrade_apply(DEGRADE_NONE);
+}
+
+void degrade_update(void)
+{
+    uint64_t faults = total_faults();
+    int current = mode.load(std::memory_order_relaxed);
+
+    if(faults != last_faults)
+    {
+        clean_windows = 0;
+        if(current < NUM_DEGRADE_MODES - 1) degrade_apply((degrade_mode_t)(current + 1));
+    }
+    else if((++clean_windows >= DEGRADE_RECOVER_WINDOWS) && (current > DEGRADE_NONE))
+    {
+        clean_windows = 0;
+        degrade_apply((degrade_mode_t)(current - 1));
+    }
+    last_faults = faults;
+}
+
+degrade_mode_t degrade_mode(void)
+{
+    return (degrade_mode_t)mode.load(std::memory_order_relaxed);
+}
+
+const char *degrade_mode_name(degrade_mode_t m)
+{
+    return ((m >= 0) && (m < NUM_DEGRADE_MODES)) ? degrade_mode_names[m] : "unknown";
+}
+
+void degrade_dump(FILE *out)
+{
+    fprintf(out, "---- degradation ----\n");
+    fprintf(out, "mode: %s\n", degrade_mode_name(degrade_mode()));
+    for(int i = DEGRADE_NO_OVERLAY; i < NUM_DEGRADE_MODES; i++)
+        fprintf(out, "entered %s: %llu times\n", degrade_mode_names[i],
+                (unsigned long long)mode_entered[i].load(std::memory_order_relaxed));
+    fflush(out);
+}
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    degrade.h
+ * @brief   This file contains declaration of the load shedding policy driven by missed deadlines
+ * @date    18th October 2026
+ *
+ * Once per second the sequencer counts the new overruns and deadline misses of
+ * all services. Any of them moves the system one mode down. Several clean
+ * seconds in a row move it one mode back up. The overlay stage goes first. The
+ * lower modes hand only every second or fourth frame to the display, and a frame
+ * that is not displayed is only decoded in the ground band the rear detector
+ * looks at, which takes most of the colour conversion out of the camera release.
+ * MJPEG frames and the OpenCV backend are always decoded whole, so there the
+ * overlay is the only real time work left to shed. The camera only captures
+ * while reversing and the rear detector runs on every frame, so capture and
+ * detection stay at full rate with motor and ultrasonic: together they form the
+ * stop path.
+ */
+
+#ifndef _DEGRADE_H
+#define _DEGRADE_H
+
+#include <stdio.h>
+
+typedef enum
+{
+    DEGRADE_NONE = 0,       // everything at full rate
+    DEGRADE_NO_OVERLAY,     // overlay stage skipped
+    DEGRADE_DISPLAY_HALF,   // and only every second frame displayed and decoded whole
+    DEGRADE_DISPLAY_QUARTER,// and only every fourth frame displayed and decoded whole
+    NUM_DEGRADE_MODES
+} degrade_mode_t;
+
+/*
+ * @brief Function to start in full mode with the counters as they are now
+ */
+void degrade_init(void);
+
+/*
+ * @brief Function called by the sequencer once per window to step the mode, sequencer thread only
+ */
+void degrade_update(void);
+
+/*
+ * @brief Function to get the current mode, safe from any thread
+ */
+degrade_mode_t degrade_mode(void);
+
+/*
+ * @brief Function to get the printable name of a mode
+ */
+const char *degrade_mode_name(degrade_mode_t mode);
+
+/*
+ * @brief Function to print the current mode and how often each mode was entered
+ */
+void degrade_dump(FILE *out);
+
+#endif
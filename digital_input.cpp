@@ -0,0 +1,306 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    digital_input.cpp
+ * @brief   This file contains definition of the edge driven digital input subsystem
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#ifdef HAL_PI
+#include <gpiod.h>
+#endif
+
+#include "digital_input.h"
+#include "rt_time.h"
+#include "rt_memory.h"
+#include "record.h"
+
+#define INPUT_POLL_NS (100000000ULL)   // wake up at least every 100 msec to check for stop
+
+static_assert((INPUT_QUEUE_SIZE & (INPUT_QUEUE_SIZE - 1)) == 0, "INPUT_QUEUE_SIZE must be a power of two");
+
+typedef struct
+{
+    struct gpiod_chip *chip;    // NULL for a virtual line
+    struct gpiod_line *line;
+    bool active_low;
+    uint64_t debounce_ns;
+    bool pressed;               // last reported state
+    uint64_t lockout_until_ns;  // 0 when no lockout is running
+    input_queue_t *queue;
+    input_notify_fn notify;
+    void *notify_arg;
+} input_line_t;
+
+static input_line_t input_lines[INPUT_MAX_LINES];
+static int num_input_lines = 0;
+static pthread_t input_thread;
+static std::atomic<bool> input_running(false);
+static size_t replay_next = 0;           // next button record of a replay
+
+void input_queue_init(input_queue_t *queue)
+{
+    queue->head.store(0, std::memory_order_relaxed);
+    queue->tail.store(0, std::memory_order_relaxed);
+    queue->dropped = 0;
+}
+
+bool input_queue_pop(input_queue_t *queue, input_event_t *event)
+{
+    uint32_t tail = queue->tail.load(std::memory_order_relaxed);
+
+    if(tail == queue->head.load(std::memory_order_acquire)) return false;
+
+    *event = queue->events[tail & (INPUT_QUEUE_SIZE - 1)];
+    queue->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+static void input_emit(int id, bool pressed, uint64_t timestamp_ns)
+{
+    input_line_t *in = &input_lines[id];
+    input_queue_t *queue = in->queue;
+    uint32_t head = queue->head.load(std::memory_order_relaxed);
+
+    in->pressed = pressed;
+    in->lockout_until_ns = timestamp_ns + in->debounce_ns;
+
+    record_button_t sample = { id, pressed };
+    record_append(RECORD_STREAM_BUTTON, 0, timestamp_ns, &sample, sizeof(sample), NULL, 0);
+
+    // Never block the input thread on a slow consumer
+    if((head - queue->tail.load(std::memory_order_acquire)) >= INPUT_QUEUE_SIZE)
+    {
+        queue->dropped++;
+        return;
+    }
+
+    input_event_t *event = &queue->events[head & (INPUT_QUEUE_SIZE - 1)];
+    event->input = id;
+    event->type = pressed ? INPUT_EVENT_PRESS : INPUT_EVENT_RELEASE;
+    event->timestamp_ns = timestamp_ns;
+    queue->head.store(head + 1, std::memory_order_release);
+
+    if(in->notify) in->notify(in->notify_arg);
+}
+
+#ifdef HAL_PI
+static void input_read_edge(int id)
+{
+    input_line_t *in = &input_lines[id];
+    struct gpiod_line_event event;
+    uint64_t timestamp_ns;
+    bool pressed;
+
+    if(gpiod_line_event_read(in->line, &event) < 0) return;
+
+    timestamp_ns = timespec_to_ns(&event.ts);
+    pressed = (event.event_type == GPIOD_LINE_EVENT_RISING_EDGE) != in->active_low;
+
+    // Bounces inside the lockout are dropped, the level is checked again when it ends
+    if((in->lockout_until_ns != 0) && (timestamp_ns < in->lockout_until_ns)) return;
+
+    if(pressed != in->pressed)
+        input_emit(id, pressed, timestamp_ns);
+}
+
+static void input_end_lockout(int id, uint64_t now)
+{
+    input_line_t *in = &input_lines[id];
+    int value;
+
+    if(!in->chip || (in->lockout_until_ns == 0) || (now < in->lockout_until_ns)) return;
+
+    in->lockout_until_ns = 0;
+    value = gpiod_line_get_value(in->line);
+    if(value < 0) return;
+
+    // The contact settled on the other level while edges were being ignored
+    if(((value != 0) != in->active_low) != in->pressed)
+        input_emit(id, !in->pressed, now);
+}
+
+static void *input_service(void *arg)
+{
+    struct pollfd fds[INPUT_MAX_LINES];
+    struct timespec timeout;
+    uint64_t now, wait_ns;
+
+    (void)arg;
+
+    rt_memory_prefault_stack();
+
+    for(int i = 0; i < num_input_lines; i++)
+    {
+        fds[i].fd = input_lines[i].chip ? gpiod_line_event_get_fd(input_lines[i].line) : -1;
+        fds[i].events = POLLIN;
+    }
+
+    while(input_running.load(std::memory_order_relaxed))
+    {
+        // Sleep until an edge, the end of the earliest lockout or the stop check
+        now = rt_now();
+        wait_ns = INPUT_POLL_NS;
+        for(int i = 0; i < num_input_lines; i++)
+        {
+            uint64_t until = input_lines[i].lockout_until_ns;
+            if(until != 0) wait_ns = (until <= now) ? 0 : ((until - now < wait_ns) ? until - now : wait_ns);
+        }
+        ns_to_timespec(wait_ns, &timeout);
+
+        if(ppoll(fds, num_input_lines, &timeout, NULL) > 0)
+        {
+            for(int i = 0; i < num_input_lines; i++)
+                if(fds[i].revents & POLLIN) input_read_edge(i);
+        }
+
+        now = rt_now();
+        for(int i = 0; i < num_input_lines; i++)
+            input_end_lockout(i, now);
+    }
+
+    return NULL;
+}
+
+int input_add_line(const char *chip_name, unsigned int line, bool active_low, uint64_t debounce_ns,
+                   input_queue_t *queue, input_notify_fn notify, void *notify_arg)
+{
+    input_line_t *in;
+    int value;
+
+    if(num_input_lines >= INPUT_MAX_LINES) return -1;
+    in = &input_lines[num_input_lines];
+    memset(in, 0, sizeof(*in));
+
+    in->active_low = active_low;
+    in->debounce_ns = debounce_ns;
+    in->queue = queue;
+    in->notify = notify;
+    in->notify_arg = notify_arg;
+
+    in->chip = gpiod_chip_open_by_name(chip_name);
+    if(!in->chip)
+    {
+        perror("gpiod_chip_open_by_name");
+        return -1;
+    }
+
+    in->line = gpiod_chip_get_line(in->chip, line);
+    if(!in->line || (gpiod_line_request_both_edges_events(in->line, "pi-parking-input") < 0))
+    {
+        perror("gpiod input line");
+        gpiod_chip_close(in->chip);
+        return -1;
+    }
+
+    // Start from the current level so a switch held at startup is not reported as a press
+    value = gpiod_line_get_value(in->line);
+    in->pressed = (value > 0) != active_low;
+
+    return num_input_lines++;
+}
+#else
+static void *input_service(void *arg)
+{
+    (void)arg;
+    return NULL;
+}
+
+int input_add_line(const char *chip_name, unsigned int line, bool active_low, uint64_t debounce_ns,
+                   input_queue_t *queue, input_notify_fn notify, void *notify_arg)
+{
+    (void)chip_name; (void)line; (void)active_low; (void)debounce_ns;
+    (void)queue; (void)notify; (void)notify_arg;
+    printf("This build has no gpiod input backend\r\n");
+    return -1;
+}
+#endif
+
+int input_add_virtual_line(input_queue_t *queue, input_notify_fn notify, void *notify_arg)
+{
+    input_line_t *in;
+
+    if(num_input_lines >= INPUT_MAX_LINES) return -1;
+    in = &input_lines[num_input_lines];
+    memset(in, 0, sizeof(*in));
+
+    in->queue = queue;
+    in->notify = notify;
+    in->notify_arg = notify_arg;
+    return num_input_lines++;
+}
+
+int input_start(pthread_attr_t *attr, pthread_t *thread)
+{
+    int rc, num_gpiod_lines = 0;
+
+    for(int i = 0; i < num_input_lines; i++)
+        if(input_lines[i].chip) num_gpiod_lines++;
+
+    // Virtual lines have no edges to wait for, their events come from input_replay_advance
+    if(num_gpiod_lines == 0) return 0;
+
+    input_running.store(true, std::memory_order_relaxed);
+    rc = pthread_create(&input_thread, attr, input_service, NULL);
+    if(rc != 0)
+    {
+        input_running.store(false, std::memory_order_relaxed);
+        printf("pthread_create for input thread failed\r\n");
+        return -1;
+    }
+
+    if(thread) *thread = input_thread;
+    return 0;
+}
+
+void input_stop(void)
+{
+    if(input_running.exchange(false))
+        pthread_join(input_thread, NULL);
+
+    for(int i = 0; i < num_input_lines; i++)
+    {
+        if(input_lines[i].queue->dropped > 0)
+            printf("Input %d dropped %u events\r\n", i, input_lines[i].queue->dropped);
+#ifdef HAL_PI
+        if(!input_lines[i].chip) continue;
+        gpiod_line_release(input_lines[i].line);
+        gpiod_chip_close(input_lines[i].chip);
+#endif
+    }
+    num_input_lines = 0;
+}
+
+void input_replay_advance(void)
+{
+    const record_reader_t *rec = replay_reader();
+    size_t count = record_reader_count(rec, RECORD_STREAM_BUTTON);
+    uint64_t now = replay_now();
+
+    while(replay_next < count)
+    {
+        const record_header_t *entry = record_reader_entry(rec, RECORD_STREAM_BUTTON, replay_next);
+        const record_button_t *sample = (const record_button_t *)record_payload(entry);
+
+        if(entry->timestamp_ns > now) break;
+        replay_next++;
+
+        // Already debounced when recorded, so the lockout is not applied again
+        if((sample->input >= 0) && (sample->input < num_input_lines))
+            input_emit(sample->input, sample->pressed != 0, replay_to_local(entry->timestamp_ns));
+    }
+}
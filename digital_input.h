@@ -0,0 +1,96 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    digital_input.h
+ * @brief   This file contains declaration of the edge driven digital input subsystem
+ * @date    18th October 2026
+ *
+ * One input thread sleeps on the gpiod edge events of all registered lines. An
+ * accepted edge starts a lockout during which bounces are ignored, and the line
+ * is sampled again when the lockout ends so a bounce that settled the other way
+ * is still reported. Press/release events go to a single consumer queue per line
+ * and the consumer is woken through its notify callback.
+ */
+
+#ifndef _DIGITAL_INPUT_H
+#define _DIGITAL_INPUT_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <atomic>
+
+#define INPUT_MAX_LINES (4)
+#define INPUT_QUEUE_SIZE (16)
+#define INPUT_DEBOUNCE_NS (20000000ULL)    // 20 msec covers the bounce of a tactile switch
+
+typedef enum
+{
+    INPUT_EVENT_PRESS = 0,
+    INPUT_EVENT_RELEASE
+} input_event_type_t;
+
+typedef struct
+{
+    int input;                  // id returned by input_add_line
+    input_event_type_t type;
+    uint64_t timestamp_ns;      // kernel CLOCK_MONOTONIC time of the edge
+} input_event_t;
+
+// Single producer (input thread), single consumer queue
+typedef struct
+{
+    alignas(64) std::atomic<uint32_t> head;
+    uint32_t dropped;                        // only written by the input thread
+    alignas(64) std::atomic<uint32_t> tail;
+    input_event_t events[INPUT_QUEUE_SIZE];
+} input_queue_t;
+
+typedef void (*input_notify_fn)(void *arg);
+
+/*
+ * @brief Function to empty a queue before it is passed to input_add_line
+ */
+void input_queue_init(input_queue_t *queue);
+
+/*
+ * @brief Function to take the oldest event from a queue, returns false when it is empty
+ */
+bool input_queue_pop(input_queue_t *queue, input_event_t *event);
+
+/*
+ * @brief Function to register a gpiod line before input_start, returns the input id or -1. Fails in builds
+ *        without HAL_PI
+ */
+int input_add_line(const char *chip_name, unsigned int line, bool active_low, uint64_t debounce_ns,
+                   input_queue_t *queue, input_notify_fn notify, void *notify_arg);
+
+/*
+ * @brief Function to register a line with no hardware behind it, its events only come from a replay
+ */
+int input_add_virtual_line(input_queue_t *queue, input_notify_fn notify, void *notify_arg);
+
+/*
+ * @brief Function to start the input thread with the given attributes, thread receives its handle when not NULL
+ */
+int input_start(pthread_attr_t *attr, pthread_t *thread);
+
+/*
+ * @brief Function to stop the input thread and release the lines
+ */
+void input_stop(void);
+
+/*
+ * @brief Function to deliver the replayed events that are due on the replay timeline, called by the sequencer
+ *        which takes the place of the input thread in a replay
+ */
+void input_replay_advance(void);
+
+#endif
@@ -0,0 +1,421 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    echo_capture.cpp
+ * @brief   This file contains definition of the edge triggered ultrasonic echo capture
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <errno.h>
+#include <atomic>
+#ifdef HAL_PI
+#include <gpiod.h>
+#include <wiringPi.h>
+#endif
+
+#include "echo_capture.h"
+#include "rt_time.h"
+#include "record.h"
+
+#define ECHO_SIM_RISE_DELAY_NS (450000)   // HC-SR04 sends its burst ~450 usec after the trigger
+#define ECHO_REPLAY_MATCH_NS (50000000ULL)  // a recorded ping older than this at the trigger is skipped
+
+#ifdef HAL_PI
+/*
+ * gpiod backend, edges are timestamped by the kernel when the interrupt fires
+ */
+typedef struct
+{
+    struct gpiod_chip *chip;
+    struct gpiod_line *line;
+    int trig_pin;
+} echo_gpiod_t;
+
+static int gpiod_trigger(echo_source_t *src)
+{
+    echo_gpiod_t *priv = (echo_gpiod_t *)src->priv;
+    struct timespec zero = {0, 0};
+    struct gpiod_line_event event;
+
+    // Discard edges left over from a previous ping that timed out
+    while(gpiod_line_event_wait(priv->line, &zero) == 1)
+        gpiod_line_event_read(priv->line, &event);
+
+    // Triggering the sensor for 10 microseconds
+    digitalWrite(priv->trig_pin, HIGH);
+    delayMicroseconds(10);
+    digitalWrite(priv->trig_pin, LOW);
+    return 0;
+}
+
+static int gpiod_wait_edge(echo_source_t *src, uint64_t deadline_ns, echo_edge_t *edge)
+{
+    echo_gpiod_t *priv = (echo_gpiod_t *)src->priv;
+    struct gpiod_line_event event;
+    struct timespec timeout;
+    uint64_t now = rt_now();
+    int rc;
+
+    // Past the deadline the edges already queued still count, a group reads them late
+    ns_to_timespec((now < deadline_ns) ? deadline_ns - now : 0, &timeout);
+
+    rc = gpiod_line_event_wait(priv->line, &timeout);
+    if(rc <= 0) return rc;
+
+    if(gpiod_line_event_read(priv->line, &event) < 0) return -1;
+
+    edge->rising = (event.event_type == GPIOD_LINE_EVENT_RISING_EDGE);
+    edge->timestamp_ns = timespec_to_ns(&event.ts);
+    return (edge->timestamp_ns <= deadline_ns) ? 1 : 0;
+}
+
+static void gpiod_close(echo_source_t *src)
+{
+    echo_gpiod_t *priv = (echo_gpiod_t *)src->priv;
+
+    gpiod_line_release(priv->line);
+    gpiod_chip_close(priv->chip);
+    delete priv;
+}
+
+static const echo_source_ops_t echo_gpiod_ops = { gpiod_trigger, gpiod_wait_edge, gpiod_close };
+
+int echo_source_open_gpiod(echo_source_t *src, const char *chip_name, unsigned int echo_line, int trig_pin)
+{
+    echo_gpiod_t *priv = new echo_gpiod_t();
+
+    priv->trig_pin = trig_pin;
+    priv->chip = gpiod_chip_open_by_name(chip_name);
+    if(!priv->chip)
+    {
+        perror("gpiod_chip_open_by_name");
+        delete priv;
+        return -1;
+    }
+
+    priv->line = gpiod_chip_get_line(priv->chip, echo_line);
+    if(!priv->line || (gpiod_line_request_both_edges_events(priv->line, "pi-parking-echo") < 0))
+    {
+        perror("gpiod echo line");
+        gpiod_chip_close(priv->chip);
+        delete priv;
+        return -1;
+    }
+
+    src->ops = &echo_gpiod_ops;
+    src->priv = priv;
+    return 0;
+}
+#else
+int echo_source_open_gpiod(echo_source_t *src, const char *chip_name, unsigned int echo_line, int trig_pin)
+{
+    (void)src; (void)chip_name; (void)echo_line; (void)trig_pin;
+    printf("This build has no gpiod echo backend\r\n");
+    return -1;
+}
+#endif
+
+/*
+ * Simulated backend, generates the edges an HC-SR04 would for the configured distance
+ */
+typedef struct
+{
+    std::atomic<int> distance_mm;
+    int (*distance_fn)(void *arg);   // when set, the distance at each trigger
+    void *distance_arg;
+    uint64_t edge_ns[2];
+    int next_edge;      // 0 rising, 1 falling, 2 none pending
+} echo_sim_t;
+
+static int sim_trigger(echo_source_t *src)
+{
+    echo_sim_t *priv = (echo_sim_t *)src->priv;
+    int distance_mm = priv->distance_fn ? priv->distance_fn(priv->distance_arg) : priv->distance_mm.load(std::memory_order_relaxed);
+
+    if(distance_mm < 0)
+    {
+        priv->next_edge = 2;
+        return 0;
+    }
+
+    priv->edge_ns[0] = rt_now() + ECHO_SIM_RISE_DELAY_NS;
+    priv->edge_ns[1] = priv->edge_ns[0] + (uint64_t)distance_mm * ECHO_NSEC_PER_MM;
+    priv->next_edge = 0;
+    return 0;
+}
+
+static int sim_wait_edge(echo_source_t *src, uint64_t deadline_ns, echo_edge_t *edge)
+{
+    echo_sim_t *priv = (echo_sim_t *)src->priv;
+    struct timespec wakeup;
+    bool have_edge = (priv->next_edge < 2) && (priv->edge_ns[priv->next_edge] <= deadline_ns);
+
+    ns_to_timespec(have_edge ? priv->edge_ns[priv->next_edge] : deadline_ns, &wakeup);
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL) == EINTR);
+
+    if(!have_edge) return 0;
+
+    edge->rising = (priv->next_edge == 0);
+    edge->timestamp_ns = priv->edge_ns[priv->next_edge];
+    priv->next_edge++;
+    return 1;
+}
+
+static void sim_close(echo_source_t *src)
+{
+    delete (echo_sim_t *)src->priv;
+}
+
+static const echo_source_ops_t echo_sim_ops = { sim_trigger, sim_wait_edge, sim_close };
+
+int echo_source_open_sim(echo_source_t *src, int distance_mm)
+{
+    echo_sim_t *priv = new echo_sim_t();
+
+    priv->distance_mm.store(distance_mm, std::memory_order_relaxed);
+    priv->next_edge = 2;
+
+    src->ops = &echo_sim_ops;
+    src->priv = priv;
+    return 0;
+}
+
+int echo_source_open_sim_fn(echo_source_t *src, int (*distance_mm)(void *arg), void *arg)
+{
+    echo_source_open_sim(src, 0);
+    ((echo_sim_t *)src->priv)->distance_fn = distance_mm;
+    ((echo_sim_t *)src->priv)->distance_arg = arg;
+    return 0;
+}
+
+void echo_source_sim_set_distance(echo_source_t *src, int distance_mm)
+{
+    if(src->ops != &echo_sim_ops) return;
+
+    ((echo_sim_t *)src->priv)->distance_mm.store(distance_mm, std::memory_order_relaxed);
+}
+
+/*
+ * Recording wrapper, passes everything to the wrapped source and appends the
+ * trigger and every edge it returns to the recording
+ */
+typedef struct
+{
+    echo_source_t inner;
+    int sensor;
+} echo_record_t;
+
+static int recorder_trigger(echo_source_t *src)
+{
+    echo_record_t *priv = (echo_record_t *)src->priv;
+    int rc = priv->inner.ops->trigger(&priv->inner);
+
+    if(rc == 0) record_append(RECORD_STREAM_ECHO, RECORD_ECHO_FLAGS(RECORD_ECHO_TRIGGER, priv->sensor), rt_now(), NULL, 0, NULL, 0);
+    return rc;
+}
+
+static int recorder_wait_edge(echo_source_t *src, uint64_t deadline_ns, echo_edge_t *edge)
+{
+    echo_record_t *priv = (echo_record_t *)src->priv;
+    int rc = priv->inner.ops->wait_edge(&priv->inner, deadline_ns, edge);
+
+    if(rc == 1)
+        record_append(RECORD_STREAM_ECHO, RECORD_ECHO_FLAGS(edge->rising ? RECORD_ECHO_RISING : RECORD_ECHO_FALLING, priv->sensor),
+                      edge->timestamp_ns, NULL, 0, NULL, 0);
+    return rc;
+}
+
+static void recorder_close(echo_source_t *src)
+{
+    echo_record_t *priv = (echo_record_t *)src->priv;
+
+    echo_source_close(&priv->inner);
+    delete priv;
+}
+
+static const echo_source_ops_t echo_record_ops = { recorder_trigger, recorder_wait_edge, recorder_close };
+
+int echo_source_record(echo_source_t *src, int sensor)
+{
+    echo_record_t *priv = new echo_record_t();
+
+    priv->inner = *src;
+    priv->sensor = sensor;
+    src->ops = &echo_record_ops;
+    src->priv = priv;
+    return 0;
+}
+
+/*
+ * Replay backend, a trigger takes the next recorded ping that is not too old on
+ * the replay timeline and its edges are moved to the local trigger time. In a
+ * fast replay nothing sleeps and the ping is placed so that its whole echo has
+ * already arrived. The pings of a group are interleaved in the stream, every
+ * source only looks at the records of its own sensor.
+ */
+typedef struct
+{
+    int sensor;
+    size_t next_ping;     // first trigger record not used yet
+    size_t edge;          // next record to look at for an edge of the current ping, 0 for none
+    uint64_t offset_ns;   // recorded to local time of the current ping
+} echo_replay_t;
+
+static int replayer_trigger(echo_source_t *src)
+{
+    echo_replay_t *priv = (echo_replay_t *)src->priv;
+    const record_reader_t *rec = replay_reader();
+    size_t count = record_reader_count(rec, RECORD_STREAM_ECHO);
+    uint64_t oldest = replay_now() - ECHO_REPLAY_MATCH_NS;
+    const record_header_t *entry;
+    size_t i;
+
+    priv->edge = 0;
+    for(i = priv->next_ping; i < count; i++)
+    {
+        entry = record_reader_entry(rec, RECORD_STREAM_ECHO, i);
+        if((entry->flags == RECORD_ECHO_FLAGS(RECORD_ECHO_TRIGGER, priv->sensor)) && (entry->timestamp_ns >= oldest)) break;
+    }
+    if(i >= count)
+    {
+        priv->next_ping = count;
+        return 0;
+    }
+
+    priv->next_ping = i + 1;
+    priv->edge = i + 1;
+    priv->offset_ns = (replay_fast() ? rt_now() - ECHO_TIMEOUT_NS : rt_now()) - entry->timestamp_ns;
+    return 0;
+}
+
+static int replayer_wait_edge(echo_source_t *src, uint64_t deadline_ns, echo_edge_t *edge)
+{
+    echo_replay_t *priv = (echo_replay_t *)src->priv;
+    const record_reader_t *rec = replay_reader();
+    size_t count = record_reader_count(rec, RECORD_STREAM_ECHO);
+    const record_header_t *entry = NULL;
+    struct timespec wakeup;
+    uint64_t edge_ns = 0;
+    bool have_edge = false;
+
+    // Skip the records of the other sensors, the next trigger of this one ends the ping
+    while((priv->edge != 0) && (priv->edge < count))
+    {
+        entry = record_reader_entry(rec, RECORD_STREAM_ECHO, priv->edge);
+        if(RECORD_ECHO_SENSOR(entry->flags) == priv->sensor) break;
+        priv->edge++;
+    }
+    if((priv->edge != 0) && (priv->edge < count))
+    {
+        edge_ns = entry->timestamp_ns + priv->offset_ns;
+        have_edge = (RECORD_ECHO_KIND(entry->flags) != RECORD_ECHO_TRIGGER) && (edge_ns <= deadline_ns);
+    }
+
+    if(!replay_fast())
+    {
+        ns_to_timespec(have_edge ? edge_ns : deadline_ns, &wakeup);
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL) == EINTR);
+    }
+
+    if(!have_edge) return 0;
+
+    edge->rising = (RECORD_ECHO_KIND(entry->flags) == RECORD_ECHO_RISING);
+    edge->timestamp_ns = edge_ns;
+    priv->edge++;
+    return 1;
+}
+
+static void replayer_close(echo_source_t *src)
+{
+    delete (echo_replay_t *)src->priv;
+}
+
+static const echo_source_ops_t echo_replay_ops = { replayer_trigger, replayer_wait_edge, replayer_close };
+
+int echo_source_open_replay(echo_source_t *src, int sensor)
+{
+    const record_reader_t *rec;
+    echo_replay_t *priv;
+    size_t i, count;
+
+    if(!replay_active()) return -1;
+
+    // A sensor that never pinged in the recording was not fitted when it was made
+    rec = replay_reader();
+    count = record_reader_count(rec, RECORD_STREAM_ECHO);
+    for(i = 0; i < count; i++)
+        if(record_reader_entry(rec, RECORD_STREAM_ECHO, i)->flags == RECORD_ECHO_FLAGS(RECORD_ECHO_TRIGGER, sensor)) break;
+    if(i >= count) return -1;
+
+    priv = new echo_replay_t();
+    priv->sensor = sensor;
+    src->ops = &echo_replay_ops;
+    src->priv = priv;
+    return 0;
+}
+
+void echo_source_close(echo_source_t *src)
+{
+    if(src->ops) src->ops->close(src);
+    src->ops = NULL;
+    src->priv = NULL;
+}
+
+// Reads the edges of one triggered source until its pulse ended or the deadline passed
+static echo_status_t echo_capture_pulse(echo_source_t *src, uint64_t deadline_ns, uint64_t *pulse_ns, uint64_t *echo_end_ns)
+{
+    echo_edge_t edge;
+    uint64_t rise_ns = 0;
+    bool risen = false;
+    int rc;
+
+    while((rc = src->ops->wait_edge(src, deadline_ns, &edge)) == 1)
+    {
+        if(edge.rising)
+        {
+            rise_ns = edge.timestamp_ns;
+            risen = true;
+        }
+        else if(risen)
+        {
+            *pulse_ns = edge.timestamp_ns - rise_ns;
+            *echo_end_ns = edge.timestamp_ns;
+            return ECHO_OK;
+        }
+        // A falling edge before any rising edge is the tail of an older pulse
+    }
+
+    if(rc < 0) return ECHO_ERROR;
+    return risen ? ECHO_OUT_OF_RANGE : ECHO_NO_ECHO;
+}
+
+echo_status_t echo_capture_measure(echo_source_t *src, uint64_t timeout_ns, uint64_t *pulse_ns, uint64_t *echo_end_ns)
+{
+    if(src->ops->trigger(src) < 0) return ECHO_ERROR;
+    return echo_capture_pulse(src, rt_now() + timeout_ns, pulse_ns, echo_end_ns);
+}
+
+void echo_capture_measure_group(echo_source_t *const srcs[], int count, uint64_t timeout_ns, echo_result_t results[])
+{
+    uint64_t deadline_ns;
+
+    for(int i = 0; i < count; i++)
+        results[i].status = (srcs[i]->ops->trigger(srcs[i]) < 0) ? ECHO_ERROR : ECHO_OK;
+    deadline_ns = rt_now() + timeout_ns;
+
+    // While waiting on one source the edges of the others are timestamped and queued
+    for(int i = 0; i < count; i++)
+        if(results[i].status == ECHO_OK)
+            results[i].status = echo_capture_pulse(srcs[i], deadline_ns, &results[i].pulse_ns, &results[i].echo_end_ns);
+}
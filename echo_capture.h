@@ -0,0 +1,122 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    echo_capture.h
+ * @brief   This file contains declaration of the edge triggered ultrasonic echo capture
+ * @date    18th October 2026
+ *
+ * The echo pulse is measured from kernel timestamped GPIO edge events, the calling
+ * thread sleeps between the edges and gives up at a hard deadline, so a lost echo
+ * can never hang the service. Edge timestamps are CLOCK_MONOTONIC nanoseconds.
+ *
+ * Several sensors can be measured at once: all of them are triggered, then their
+ * edges are read one source after the other. The kernel timestamps the edges
+ * of the later sources while the thread waits on the earlier ones, so the group
+ * takes as long as its longest echo, not the sum of them.
+ */
+
+#ifndef _ECHO_CAPTURE_H
+#define _ECHO_CAPTURE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define ECHO_NSEC_PER_MM (5831)          // round trip time of sound per mm of distance
+#define ECHO_TIMEOUT_NS (30000000ULL)     // 30 msec covers the 4 m range of the HC-SR04
+
+typedef struct
+{
+    bool rising;
+    uint64_t timestamp_ns;
+} echo_edge_t;
+
+typedef struct echo_source echo_source_t;
+
+/*
+ * Backend operations of an echo source. wait_edge returns 1 with the next edge,
+ * 0 when the deadline passed first and -1 on error.
+ */
+typedef struct
+{
+    int (*trigger)(echo_source_t *src);
+    int (*wait_edge)(echo_source_t *src, uint64_t deadline_ns, echo_edge_t *edge);
+    void (*close)(echo_source_t *src);
+} echo_source_ops_t;
+
+struct echo_source
+{
+    const echo_source_ops_t *ops;
+    void *priv;
+};
+
+typedef enum
+{
+    ECHO_OK = 0,
+    ECHO_NO_ECHO,          // the echo line never went high
+    ECHO_OUT_OF_RANGE,     // the echo line went high but did not fall before the deadline
+    ECHO_ERROR
+} echo_status_t;
+
+typedef struct
+{
+    echo_status_t status;
+    uint64_t pulse_ns;         // ECHO_OK only
+    uint64_t echo_end_ns;      // ECHO_OK only
+} echo_result_t;
+
+/*
+ * @brief Function to open an echo source on a gpiod line, the trigger pin is driven through wiringPi.
+ *        Fails in builds without HAL_PI
+ */
+int echo_source_open_gpiod(echo_source_t *src, const char *chip_name, unsigned int echo_line, int trig_pin);
+
+/*
+ * @brief Function to open a simulated echo source, a negative distance simulates a lost echo
+ */
+int echo_source_open_sim(echo_source_t *src, int distance_mm);
+
+/*
+ * @brief Function to open a simulated echo source that asks for the distance at every trigger
+ */
+int echo_source_open_sim_fn(echo_source_t *src, int (*distance_mm)(void *arg), void *arg);
+
+/*
+ * @brief Function to change the distance reported by a simulated echo source
+ */
+void echo_source_sim_set_distance(echo_source_t *src, int distance_mm);
+
+/*
+ * @brief Function to open an echo source that replays the pings of one sensor of the recording given to replay_open,
+ *        fails when the recording has no ping of that sensor
+ */
+int echo_source_open_replay(echo_source_t *src, int sensor);
+
+/*
+ * @brief Function to wrap an open echo source so its pings are appended to the recording under the sensor index
+ */
+int echo_source_record(echo_source_t *src, int sensor);
+
+/*
+ * @brief Function to close an echo source
+ */
+void echo_source_close(echo_source_t *src);
+
+/*
+ * @brief Function to trigger one ping and measure the echo pulse width, gives up after timeout_ns
+ */
+echo_status_t echo_capture_measure(echo_source_t *src, uint64_t timeout_ns, uint64_t *pulse_ns, uint64_t *echo_end_ns);
+
+/*
+ * @brief Function to trigger count sensors together and measure all their echo pulses, gives up after timeout_ns
+ */
+void echo_capture_measure_group(echo_source_t *const srcs[], int count, uint64_t timeout_ns, echo_result_t results[]);
+
+#endif
@@ -0,0 +1,263 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    frame_pipeline.cpp
+ * @brief   This file contains definition of the capture/processing/presentation frame pipeline
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <atomic>
+
+#include <opencv2/highgui/highgui.hpp>
+
+#include "frame_pipeline.h"
+#include "latency_histogram.h"
+#include "service_stats.h"
+#include "rt_time.h"
+
+using namespace cv;
+
+#define SLOT_MASK (0x3)
+#define SLOT_FRESH (0x4)          // middle slot holds a frame the reader has not taken yet
+#define DISPLAY_WAIT_NS (100000000)
+
+typedef struct
+{
+    const char *name;
+    frame_stage_fn fn;
+    void *arg;
+    std::atomic<bool> enabled;      // cleared by the degrade policy to shed the stage
+    latency_histogram_t latency;
+} pipeline_stage_t;
+
+static pipeline_frame_t slots[3];
+static uint32_t back_slot = 0;                // owned by the capture stage
+static uint32_t front_slot = 1;               // owned by the presentation stage
+static std::atomic<uint32_t> middle_slot(2);
+static std::atomic<uint64_t> frames_dropped(0);
+static std::atomic<unsigned int> present_shift(0);   // set by the degrade policy
+static uint32_t frames_processed = 0;         // owned by the capture stage
+static bool present_next = true;              // whether the next processed frame is published, owned by the capture stage
+
+static pipeline_stage_t stages[FRAME_PIPELINE_MAX_STAGES];
+static int num_stages = 0;
+static latency_histogram_t capture_latency;   // capture timestamp to submit, written by the capture stage
+static latency_histogram_t present_latency;   // publish to shown, written by the presentation stage
+static latency_histogram_t glass_latency;     // capture timestamp to shown, written by the presentation stage
+
+static sem_t display_sem;
+static pthread_t display_thread;
+static std::atomic<bool> display_running(false);
+static const char *display_window;
+static std::atomic<uint64_t> publish_ns[3];
+
+void frame_pipeline_init(Size size, int type)
+{
+    for(int i = 0; i < 3; i++)
+    {
+        slots[i].image = Mat::zeros(size, type);
+        slots[i].capture_ns = 0;
+        slots[i].seq = 0;
+        publish_ns[i].store(0, std::memory_order_relaxed);
+    }
+
+    latency_histogram_init(&capture_latency);
+    latency_histogram_init(&present_latency);
+    latency_histogram_init(&glass_latency);
+    sem_init(&display_sem, 0, 0);
+}
+
+int frame_pipeline_add_stage(const char *name, frame_stage_fn fn, void *arg)
+{
+    if(num_stages >= FRAME_PIPELINE_MAX_STAGES) return -1;
+
+    stages[num_stages].name = name;
+    stages[num_stages].fn = fn;
+    stages[num_stages].arg = arg;
+    stages[num_stages].enabled.store(true, std::memory_order_relaxed);
+    latency_histogram_init(&stages[num_stages].latency);
+    num_stages++;
+    return 0;
+}
+
+pipeline_frame_t *frame_pipeline_back(void)
+{
+    return &slots[back_slot];
+}
+
+void frame_pipeline_submit(bool process)
+{
+    pipeline_frame_t *frame = &slots[back_slot];
+    uint64_t t0 = rt_now(), t1;
+    uint32_t prev;
+
+    if(t0 >= frame->capture_ns)
+        latency_histogram_record(&capture_latency, t0 - frame->capture_ns);
+
+    for(int i = 0; process && (i < num_stages); i++)
+    {
+        if(!stages[i].enabled.load(std::memory_order_relaxed)) continue;
+        stages[i].fn(frame, stages[i].arg);
+        t1 = rt_now();
+        latency_histogram_record(&stages[i].latency, t1 - t0);
+        t0 = t1;
+    }
+
+    // Shed presentation, the detector above has already seen the frame. The
+    // decision for the next frame is taken now so the capture stage can act on it
+    if(process)
+    {
+        bool present = present_next;
+
+        frames_processed++;
+        present_next = (frames_processed & ((1u << present_shift.load(std::memory_order_relaxed)) - 1)) == 0;
+        if(!present) return;
+    }
+
+    // Swap the finished back slot into the middle, a still fresh middle frame was never shown
+    publish_ns[back_slot].store(t0, std::memory_order_relaxed);
+    prev = middle_slot.exchange(back_slot | SLOT_FRESH, std::memory_order_acq_rel);
+    back_slot = prev & SLOT_MASK;
+    if(prev & SLOT_FRESH)
+        frames_dropped.fetch_add(1, std::memory_order_relaxed);
+
+    sem_post(&display_sem);
+}
+
+bool frame_pipeline_presents_next(void)
+{
+    return present_next;
+}
+
+void frame_pipeline_set_present_shift(unsigned int shift)
+{
+    present_shift.store(shift, std::memory_order_relaxed);
+}
+
+int frame_pipeline_enable_stage(const char *name, bool enabled)
+{
+    for(int i = 0; i < num_stages; i++)
+    {
+        if(strcmp(stages[i].name, name) == 0)
+        {
+            stages[i].enabled.store(enabled, std::memory_order_relaxed);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static pipeline_frame_t *frame_pipeline_latest(void)
+{
+    if(!(middle_slot.load(std::memory_order_acquire) & SLOT_FRESH))
+        return NULL;
+
+    front_slot = middle_slot.exchange(front_slot, std::memory_order_acq_rel) & SLOT_MASK;
+    return &slots[front_slot];
+}
+
+static void *display_service(void *arg)
+{
+    struct timespec timeout;
+    pipeline_frame_t *frame;
+    uint64_t shown_ns, published_ns;
+
+    (void)arg;
+
+    namedWindow(display_window);
+
+    while(display_running.load(std::memory_order_relaxed))
+    {
+        // On the monotonic timeline, a wall clock step cannot stretch the wait
+        ns_to_timespec(rt_now() + DISPLAY_WAIT_NS, &timeout);
+        if((sem_clockwait(&display_sem, CLOCK_MONOTONIC, &timeout) == 0) && ((frame = frame_pipeline_latest()) != NULL))
+        {
+            imshow(display_window, frame->image);
+            waitKey(1);
+
+            shown_ns = rt_now();
+            published_ns = publish_ns[front_slot].load(std::memory_order_relaxed);
+            if(shown_ns >= published_ns)
+                latency_histogram_record(&present_latency, shown_ns - published_ns);
+            if(shown_ns >= frame->capture_ns)
+                latency_histogram_record(&glass_latency, shown_ns - frame->capture_ns);
+        }
+        else
+        {
+            // Keep the GUI responsive while no frames arrive
+            waitKey(1);
+        }
+    }
+
+    destroyWindow(display_window);
+    return NULL;
+}
+
+int frame_pipeline_start_display(const char *window)
+{
+    pthread_attr_t attr;
+    struct sched_param param;
+    int rc;
+
+    display_window = window;
+
+    // Presentation must never delay capture, so it runs outside the RT class
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    param.sched_priority = 0;
+    pthread_attr_setschedparam(&attr, &param);
+
+    display_running.store(true, std::memory_order_relaxed);
+    rc = pthread_create(&display_thread, &attr, display_service, NULL);
+    pthread_attr_destroy(&attr);
+    if(rc != 0)
+    {
+        display_running.store(false, std::memory_order_relaxed);
+        printf("pthread_create for display failed\r\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+void frame_pipeline_stop_display(void)
+{
+    if(!display_running.exchange(false))
+        return;
+
+    sem_post(&display_sem);
+    pthread_join(display_thread, NULL);
+}
+
+void frame_pipeline_dump(FILE *out)
+{
+    char name[64];
+
+    fprintf(out, "---- frame pipeline ----\n");
+    latency_histogram_print(out, "capture->stages", &capture_latency);
+    for(int i = 0; i < num_stages; i++)
+    {
+        snprintf(name, sizeof(name), "stage %s", stages[i].name);
+        latency_histogram_print(out, name, &stages[i].latency);
+    }
+    latency_histogram_print(out, "publish->shown", &present_latency);
+    latency_histogram_print(out, "glass-to-glass", &glass_latency);
+    fprintf(out, "frames dropped by display: %llu\n", (unsigned long long)frames_dropped.load(std::memory_order_relaxed));
+    fflush(out);
+}
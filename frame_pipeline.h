@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    frame_pipeline.h
+ * @brief   This file contains declaration of the capture/processing/presentation frame pipeline
+ * @date    18th October 2026
+ *
+ * The RT camera service captures into the back slot of a lock-free triple buffer
+ * of preallocated frames, runs the registered processing stages on it in place
+ * and publishes it. A non-RT presentation thread always shows the newest
+ * published frame, frames it was too slow for are dropped, never waited for.
+ */
+
+#ifndef _FRAME_PIPELINE_H
+#define _FRAME_PIPELINE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+#define FRAME_PIPELINE_MAX_STAGES (4)
+
+typedef struct
+{
+    cv::Mat image;
+    uint64_t capture_ns;   // when the frame was captured, CLOCK_MONOTONIC
+    uint32_t seq;
+} pipeline_frame_t;
+
+/*
+ * A processing stage works on the frame in place inside the camera service budget
+ */
+typedef void (*frame_stage_fn)(pipeline_frame_t *frame, void *arg);
+
+/*
+ * @brief Function to preallocate the frame slots, must be called before anything else
+ */
+void frame_pipeline_init(cv::Size size, int type);
+
+/*
+ * @brief Function to append a processing stage, must be called before the camera service starts
+ */
+int frame_pipeline_add_stage(const char *name, frame_stage_fn fn, void *arg);
+
+/*
+ * @brief Function to get the slot the capture stage writes the next frame into
+ */
+pipeline_frame_t *frame_pipeline_back(void);
+
+/*
+ * @brief Function to run the processing stages on the back slot (unless process is false) and publish it
+ *        to the presentation stage
+ */
+void frame_pipeline_submit(bool process);
+
+/*
+ * @brief Function to skip or run again a registered stage, safe from any thread, returns -1 for an unknown name
+ */
+int frame_pipeline_enable_stage(const char *name, bool enabled);
+
+/*
+ * @brief Function to publish only every 2^shift-th processed frame to the presentation stage, for load shedding.
+ *        The stages still run on every frame. Safe from any thread
+ */
+void frame_pipeline_set_present_shift(unsigned int shift);
+
+/*
+ * @brief Function to tell whether the next processed frame goes to the presentation stage, capture stage only.
+ *        A frame that is not presented only needs the part the stages look at
+ */
+bool frame_pipeline_presents_next(void);
+
+/*
+ * @brief Function to start the non-RT presentation thread showing frames in the given window
+ */
+int frame_pipeline_start_display(const char *window);
+
+/*
+ * @brief Function to stop the presentation thread and close its window
+ */
+void frame_pipeline_stop_display(void);
+
+/*
+ * @brief Function to print the per-stage and glass-to-glass latencies and drop count
+ */
+void frame_pipeline_dump(FILE *out);
+
+#endif
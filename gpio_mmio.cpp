@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    gpio_mmio.cpp
+ * @brief   This file contains definition of the memory mapped GPIO register backend
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "gpio_mmio.h"
+
+int gpio_mmio_open(gpio_mmio_t *gpio)
+{
+    int fd;
+    void *map;
+
+    fd = open("/dev/gpiomem", O_RDWR | O_SYNC | O_CLOEXEC);
+    if(fd < 0)
+    {
+        perror("open /dev/gpiomem");
+        return -1;
+    }
+
+    map = mmap(NULL, GPIO_MMIO_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+    {
+        perror("mmap /dev/gpiomem");
+        return -1;
+    }
+
+    gpio->regs = (volatile uint32_t *)map;
+    gpio->map_len = GPIO_MMIO_MAP_SIZE;
+    gpio->fake = false;
+    return 0;
+}
+
+int gpio_mmio_open_fake(gpio_mmio_t *gpio)
+{
+    void *regs = calloc(1, GPIO_MMIO_MAP_SIZE);
+
+    if(regs == NULL) return -1;
+
+    gpio->regs = (volatile uint32_t *)regs;
+    gpio->map_len = GPIO_MMIO_MAP_SIZE;
+    gpio->fake = true;
+    return 0;
+}
+
+void gpio_mmio_close(gpio_mmio_t *gpio)
+{
+    if(gpio->regs == NULL) return;
+
+    if(gpio->fake)
+        free((void *)gpio->regs);
+    else
+        munmap((void *)gpio->regs, gpio->map_len);
+    gpio->regs = NULL;
+}
+
+void gpio_mmio_set_output(gpio_mmio_t *gpio, int bcm)
+{
+    int reg = GPIO_MMIO_GPFSEL0 + bcm / 10;
+    int shift = (bcm % 10) * 3;
+
+    gpio->regs[reg] = (gpio->regs[reg] & ~(7u << shift)) | (1u << shift);
+}
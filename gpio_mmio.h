@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    gpio_mmio.h
+ * @brief   This file contains declaration of the memory mapped GPIO register backend
+ * @date    18th October 2026
+ *
+ * The BCM283x/BCM2711 GPIO block is mapped through /dev/gpiomem, which needs no
+ * root. GPSET0/GPCLR0 change any set of bank 0 pins with one store each. A fake
+ * backend keeps the registers in memory so the same code runs on any Linux box.
+ */
+
+#ifndef _GPIO_MMIO_H
+#define _GPIO_MMIO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define GPIO_MMIO_MAP_SIZE (4096)
+#define GPIO_MMIO_GPFSEL0 (0x00 / 4)     // 3 function bits per pin, 10 pins per register
+#define GPIO_MMIO_GPSET0 (0x1c / 4)      // write 1 to drive the pin high
+#define GPIO_MMIO_GPCLR0 (0x28 / 4)      // write 1 to drive the pin low
+#define GPIO_MMIO_GPLEV0 (0x34 / 4)      // current pin levels
+
+#define GPIO_MMIO_BIT(bcm) (1u << (bcm))
+
+typedef struct
+{
+    volatile uint32_t *regs;
+    size_t map_len;
+    bool fake;
+} gpio_mmio_t;
+
+/*
+ * @brief Function to map the GPIO registers from /dev/gpiomem, returns -1 when not on a Pi
+ */
+int gpio_mmio_open(gpio_mmio_t *gpio);
+
+/*
+ * @brief Function to open an in-memory register file that behaves like the GPIO block for bank 0
+ */
+int gpio_mmio_open_fake(gpio_mmio_t *gpio);
+
+/*
+ * @brief Function to unmap or free the registers
+ */
+void gpio_mmio_close(gpio_mmio_t *gpio);
+
+/*
+ * @brief Function to switch a BCM pin to output
+ */
+void gpio_mmio_set_output(gpio_mmio_t *gpio, int bcm);
+
+/*
+ * @brief Function to drive the bank 0 pins in clr_mask low, then the ones in set_mask high
+ *
+ * Clearing first means a pin pair that swaps levels passes through low/low and
+ * never through high/high.
+ */
+static inline void gpio_mmio_write(gpio_mmio_t *gpio, uint32_t set_mask, uint32_t clr_mask)
+{
+    gpio->regs[GPIO_MMIO_GPCLR0] = clr_mask;
+    gpio->regs[GPIO_MMIO_GPSET0] = set_mask;
+
+    if(gpio->fake)
+    {
+        // Real hardware folds the write-only set/clear registers into the level register
+        gpio->regs[GPIO_MMIO_GPLEV0] = (gpio->regs[GPIO_MMIO_GPLEV0] & ~clr_mask) | set_mask;
+    }
+}
+
+/*
+ * @brief Function to read the levels of the bank 0 pins
+ */
+static inline uint32_t gpio_mmio_levels(gpio_mmio_t *gpio)
+{
+    return gpio->regs[GPIO_MMIO_GPLEV0];
+}
+
+#endif
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    hal.cpp
+ * @brief   This file contains definition of the vehicle hardware abstraction backend selection
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+
+#include "hal.h"
+
+#ifdef HAL_PI
+extern const hal_ops_t hal_pi_ops;
+#endif
+extern const hal_ops_t hal_sim_ops;
+
+static const hal_ops_t *hal_backends[NUM_HAL_BACKENDS] =
+{
+#ifdef HAL_PI
+    &hal_pi_ops,
+#else
+    NULL,           // built without wiringPi and gpiod
+#endif
+    &hal_sim_ops,
+};
+
+static hal_backend_t hal_backend = hal_default_backend();
+
+hal_backend_t hal_default_backend(void)
+{
+#ifdef HAL_PI
+    return HAL_BACKEND_PI;
+#else
+    return HAL_BACKEND_SIM;
+#endif
+}
+
+int hal_select(hal_backend_t backend)
+{
+    if(!hal_backends[backend])
+    {
+        printf("This build has no Raspberry Pi backend, rebuild with HAL_PI defined\r\n");
+        return -1;
+    }
+
+    hal_backend = backend;
+    return 0;
+}
+
+const hal_ops_t *hal(void)
+{
+    return hal_backends[hal_backend];
+}
+
+bool hal_simulated(void)
+{
+    return hal_backend == HAL_BACKEND_SIM;
+}
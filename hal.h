@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    hal.h
+ * @brief   This file contains declaration of the vehicle hardware abstraction
+ * @date    18th October 2026
+ *
+ * The motor and ultrasonic services only use the vehicle hardware through the
+ * operations of the selected backend:
+ *  - pi: wiringPi for the pins and PWM, the GPIO registers for the direction
+ *        pins, gpiod for the echo and the button. Only built with HAL_PI defined
+ *        (make sim builds without it, so nothing links against wiringPi or gpiod)
+ *  - sim: the motors drive the vehicle model of vehicle_sim.h, every sensor of
+ *         the array is fitted and its echo is timed from the gap to the wall
+ *         along its beam, the button is a virtual line
+ *
+ * Select the backend once, before setup_gpio.
+ */
+
+#ifndef _HAL_H
+#define _HAL_H
+
+#include <stdint.h>
+
+#include "echo_capture.h"
+#include "digital_input.h"
+
+typedef enum
+{
+    HAL_BACKEND_PI = 0,
+    HAL_BACKEND_SIM,
+    NUM_HAL_BACKENDS
+} hal_backend_t;
+
+typedef struct
+{
+    const char *name;
+    int (*setup)(void);                                 // pins, pull-ups, motor driver out of standby
+    void (*motor_pwm)(int motor, int duty);             // duty 0 to 1023
+    void (*motor_direction)(const int direction[2]);    // both motors at once, 1 forward
+    bool (*echo_fitted)(int sensor);                    // ultrasonic_id_t, whether the vehicle has that sensor
+    int (*open_echo)(int sensor, echo_source_t *src);
+    int (*add_button)(input_queue_t *queue, input_notify_fn notify, void *notify_arg);   // returns the input id
+} hal_ops_t;
+
+/*
+ * @brief Function to select the backend, fails for a backend this build does not include
+ */
+int hal_select(hal_backend_t backend);
+
+/*
+ * @brief Function to get the operations of the selected backend
+ */
+const hal_ops_t *hal(void);
+
+/*
+ * @brief Function to check whether the selected backend is the simulation
+ */
+bool hal_simulated(void);
+
+/*
+ * @brief Function to get the backend a build uses when none is selected, the pi when it is built in
+ */
+hal_backend_t hal_default_backend(void);
+
+#endif
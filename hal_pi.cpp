@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    hal_pi.cpp
+ * @brief   This file contains definition of the Raspberry Pi backend of the vehicle hardware abstraction
+ * @date    18th October 2026
+ *
+ */
+
+#ifdef HAL_PI
+
+#include <stdio.h>
+#include <wiringPi.h>
+
+#include "hal.h"
+#include "gpio_mmio.h"
+#include "ultrasonic_sensor.h"
+
+// GPIO pin definitions
+#define MOTOR_PWM_A 1  // PWM for Motor A (GPIO 18)
+#define MOTOR_IN1_A 4  // Direction IN1 for Motor A (GPIO 23)
+#define MOTOR_IN2_A 5  // Direction IN2 for Motor A (GPIO 24)
+#define MOTOR_PWM_B 23 // PWM for Motor B (GPIO 13)
+#define MOTOR_IN1_B 3  // Direction IN1 for Motor B (GPIO 22, WiringPi pin 3)
+#define MOTOR_IN2_B 2  // Direction IN2 for Motor B (GPIO 27, WiringPi pin 2)
+#define STBY_PIN 6     // Standby pin (GPIO 25)
+#define BUTTON_PIN 7   // Button pin (GPIO 4, WiringPi pin 7)
+#define BUTTON_GPIO_CHIP "gpiochip0"
+#define BUTTON_GPIO_LINE 4   // BCM number of wiringPi pin 7
+
+// BCM numbers of the direction pins for the register backend
+#define MOTOR_BCM_IN1_A 23
+#define MOTOR_BCM_IN2_A 24
+#define MOTOR_BCM_IN1_B 22
+#define MOTOR_BCM_IN2_B 27
+
+#define ECHO_GPIO_CHIP "gpiochip0"
+
+// Pins of one ultrasonic sensor: the trigger is driven through wiringPi, the echo is read through gpiod
+typedef struct
+{
+    int trig_wpi;   // trigger, wiringPi numbering, -1 when the sensor is not fitted
+    int echo_bcm;   // echo, BCM line number on ECHO_GPIO_CHIP
+} echo_pins_t;
+
+static const echo_pins_t echo_pins[NUM_ULTRASONIC_SENSORS] =
+{
+    { 15, 15 },     // front, TRIG on GPIO 14 (WiringPi pin 15), ECHO on GPIO 15 (WiringPi pin 16)
+    { -1, -1 },     // front left
+    { -1, -1 },     // front right
+    { -1, -1 },     // rear
+};
+
+static gpio_mmio_t gpio_regs;
+static bool gpio_regs_mapped = false;
+
+static int pi_setup(void)
+{
+    wiringPiSetup();
+    pinMode(BUTTON_PIN, INPUT);  // Set button pin as input
+    pullUpDnControl(BUTTON_PIN, PUD_UP);  // Enable pull-up resistor
+    pinMode(MOTOR_PWM_A, PWM_OUTPUT);
+    pinMode(MOTOR_IN1_A, OUTPUT);
+    pinMode(MOTOR_IN2_A, OUTPUT);
+    pinMode(MOTOR_PWM_B, PWM_OUTPUT);
+    pinMode(MOTOR_IN1_B, OUTPUT);
+    pinMode(MOTOR_IN2_B, OUTPUT);
+    pinMode(STBY_PIN, OUTPUT);
+    digitalWrite(STBY_PIN, HIGH);  // Take motor driver out of standby mode
+
+    // Direction pins go through the registers when available, wiringPi otherwise
+    gpio_regs_mapped = (gpio_mmio_open(&gpio_regs) == 0);
+    printf("Motor direction pins via %s\r\n", gpio_regs_mapped ? "/dev/gpiomem" : "wiringPi");
+    return 0;
+}
+
+static void pi_motor_pwm(int motor, int duty)
+{
+    static const int pwm_pin[2] = { MOTOR_PWM_A, MOTOR_PWM_B };
+
+    pwmWrite(pwm_pin[motor], duty);
+}
+
+static void pi_motor_direction(const int direction[2])
+{
+    static const int in1_pin[2] = { MOTOR_IN1_A, MOTOR_IN1_B };
+    static const int in2_pin[2] = { MOTOR_IN2_A, MOTOR_IN2_B };
+    static const int in1_bcm[2] = { MOTOR_BCM_IN1_A, MOTOR_BCM_IN1_B };
+    static const int in2_bcm[2] = { MOTOR_BCM_IN2_A, MOTOR_BCM_IN2_B };
+    uint32_t set_mask = 0, clr_mask = 0;
+
+    if(gpio_regs_mapped)
+    {
+        for(int m = 0; m < 2; m++)
+        {
+            if(direction[m])
+            {
+                set_mask |= GPIO_MMIO_BIT(in1_bcm[m]);
+                clr_mask |= GPIO_MMIO_BIT(in2_bcm[m]);
+            }
+            else
+            {
+                set_mask |= GPIO_MMIO_BIT(in2_bcm[m]);
+                clr_mask |= GPIO_MMIO_BIT(in1_bcm[m]);
+            }
+        }
+        // All four direction pins in one clear and one set
+        gpio_mmio_write(&gpio_regs, set_mask, clr_mask);
+    }
+    else
+    {
+        for(int m = 0; m < 2; m++)
+        {
+            digitalWrite(in1_pin[m], direction[m] ? HIGH : LOW);
+            digitalWrite(in2_pin[m], direction[m] ? LOW : HIGH);
+        }
+    }
+}
+
+static bool pi_echo_fitted(int sensor)
+{
+    return echo_pins[sensor].trig_wpi >= 0;
+}
+
+static int pi_open_echo(int sensor, echo_source_t *src)
+{
+    int trig_pin = echo_pins[sensor].trig_wpi;
+
+    pinMode(trig_pin, OUTPUT);
+
+    // Ensure the trigger pin is low
+    digitalWrite(trig_pin, LOW);
+    delay(30);
+
+    return echo_source_open_gpiod(src, ECHO_GPIO_CHIP, echo_pins[sensor].echo_bcm, trig_pin);
+}
+
+static int pi_add_button(input_queue_t *queue, input_notify_fn notify, void *notify_arg)
+{
+    // The button reads 1 when pressed, edges are delivered by the input thread
+    return input_add_line(BUTTON_GPIO_CHIP, BUTTON_GPIO_LINE, false, INPUT_DEBOUNCE_NS, queue, notify, notify_arg);
+}
+
+extern const hal_ops_t hal_pi_ops;
+const hal_ops_t hal_pi_ops = { "pi", pi_setup, pi_motor_pwm, pi_motor_direction, pi_echo_fitted, pi_open_echo, pi_add_button };
+
+#endif
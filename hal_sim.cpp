@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    hal_sim.cpp
+ * @brief   This file contains definition of the simulation backend of the vehicle hardware abstraction
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "hal.h"
+#include "vehicle_sim.h"
+#include "ultrasonic_sensor.h"
+
+#define SIM_NO_WALL_MM (6000)   // beyond the echo timeout, the sensor reads out of range
+
+static int sim_setup(void)
+{
+    printf("Motors drive the simulated vehicle\r\n");
+    return 0;
+}
+
+static void sim_motor_pwm(int motor, int duty)
+{
+    vehicle_sim_set_duty(motor, duty);
+}
+
+static void sim_motor_direction(const int direction[2])
+{
+    for(int m = 0; m < 2; m++)
+        vehicle_sim_set_direction(m, direction[m]);
+}
+
+// The wall is square across the path ahead, an angled beam meets it further out
+static int sim_range_mm(void *arg)
+{
+    const ultrasonic_desc_t *desc = (const ultrasonic_desc_t *)arg;
+
+    if(desc->facing != GEAR_FORWARD) return SIM_NO_WALL_MM;
+    return (int)(vehicle_sim_range_mm() / cos(desc->angle_deg * M_PI / 180.0));
+}
+
+static bool sim_echo_fitted(int sensor)
+{
+    (void)sensor;
+    return true;
+}
+
+static int sim_open_echo(int sensor, echo_source_t *src)
+{
+    // Each ping is timed from the gap to the wall at its trigger
+    return echo_source_open_sim_fn(src, sim_range_mm, (void *)ultrasonic_desc(sensor));
+}
+
+static int sim_add_button(input_queue_t *queue, input_notify_fn notify, void *notify_arg)
+{
+    return input_add_virtual_line(queue, notify, notify_arg);
+}
+
+extern const hal_ops_t hal_sim_ops;
+const hal_ops_t hal_sim_ops = { "sim", sim_setup, sim_motor_pwm, sim_motor_direction, sim_echo_fitted, sim_open_echo, sim_add_button };
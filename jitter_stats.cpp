@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    jitter_stats.cpp
+ * @brief   This file contains definition of the sequencer release jitter statistics
+ * @date    3rd May 2024
+ *
+ */
+
+#include <string.h>
+
+#include "jitter_stats.h"
+
+void jitter_stats_init(jitter_stats_t *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+  stats->min_ns = INT64_MAX;
+  stats->max_ns = INT64_MIN;
+}
+
+void jitter_stats_record(jitter_stats_t *stats, int64_t jitter_ns)
+{
+  if(jitter_ns < stats->min_ns) stats->min_ns = jitter_ns;
+  if(jitter_ns > stats->max_ns) stats->max_ns = jitter_ns;
+  stats->sum_ns += jitter_ns;
+  stats->count++;
+
+  // Early wakeups are folded into the first bucket, they only matter for min
+  int64_t bucket = (jitter_ns < 0) ? 0 : (jitter_ns / JITTER_BUCKET_NS);
+  if(bucket < JITTER_NUM_BUCKETS)
+    stats->buckets[bucket]++;
+  else
+    stats->overflow++;
+}
+
+int64_t jitter_stats_percentile(const jitter_stats_t *stats, double percentile)
+{
+  uint64_t target = (uint64_t)((percentile / 100.0) * (double)stats->count);
+  uint64_t seen = 0;
+
+  if(stats->count == 0) return 0;
+  if(target >= stats->count) target = stats->count - 1;
+
+  for(int i = 0; i < JITTER_NUM_BUCKETS; i++)
+  {
+    seen += stats->buckets[i];
+    if(seen > target) return (int64_t)(i + 1) * JITTER_BUCKET_NS;
+  }
+
+  // Percentile falls in the overflow region, the max is the best bound we have
+  return stats->max_ns;
+}
+
+void jitter_stats_print(const char *name, const jitter_stats_t *stats)
+{
+  if(stats->count == 0)
+  {
+    printf("%s: no samples\n", name);
+    return;
+  }
+
+  printf("%s: samples=%llu min=%lld usec max=%lld usec mean=%lld usec p99<=%lld usec overflow=%llu\n",
+         name, (unsigned long long)stats->count,
+         (long long)(stats->min_ns / NSEC_PER_MICROSEC), (long long)(stats->max_ns / NSEC_PER_MICROSEC),
+         (long long)((stats->sum_ns / (int64_t)stats->count) / NSEC_PER_MICROSEC),
+         (long long)(jitter_stats_percentile(stats, 99.0) / NSEC_PER_MICROSEC),
+         (unsigned long long)stats->overflow);
+}
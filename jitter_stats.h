@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    jitter_stats.h
+ * @brief   This file contains declaration of the sequencer release jitter statistics
+ * @date    3rd May 2024
+ *
+ */
+
+#ifndef _JITTER_STATS_H
+#define _JITTER_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "rt_time.h"
+
+#define JITTER_BUCKET_NS (10 * NSEC_PER_MICROSEC)   // 10 usec resolution
+#define JITTER_NUM_BUCKETS (1000)                   // covers 0 - 10 msec
+
+/*
+ * Release jitter statistics, one bucket per 10 usec for the percentile estimate
+ */
+typedef struct
+{
+    uint64_t count;
+    int64_t min_ns;
+    int64_t max_ns;
+    int64_t sum_ns;
+    uint64_t overflow;
+    uint32_t buckets[JITTER_NUM_BUCKETS];
+} jitter_stats_t;
+
+/*
+ * @brief Function to reset the jitter statistics
+ */
+void jitter_stats_init(jitter_stats_t *stats);
+
+/*
+ * @brief Function to add one jitter sample (in nanoseconds) to the statistics
+ */
+void jitter_stats_record(jitter_stats_t *stats, int64_t jitter_ns);
+
+/*
+ * @brief Function to get the upper bound of the given percentile (0 - 100) in nanoseconds
+ */
+int64_t jitter_stats_percentile(const jitter_stats_t *stats, double percentile);
+
+/*
+ * @brief Function to print min/max/mean/p99 of the jitter statistics
+ */
+void jitter_stats_print(const char *name, const jitter_stats_t *stats);
+
+#endif
@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    latency_histogram.cpp
+ * @brief   This file contains definition of the fixed memory log bucketed latency histogram
+ * @date    18th October 2026
+ *
+ */
+
+#include "latency_histogram.h"
+
+static inline uint32_t bucket_index(uint64_t value)
+{
+    if(value < HIST_SUB_BUCKETS) return (uint32_t)value;
+
+    // Position of the leading one selects the power of two range, the next
+    // HIST_SUB_BUCKET_BITS bits select the linear sub bucket inside it
+    uint32_t msb = 63 - __builtin_clzll(value);
+    uint32_t shift = msb - HIST_SUB_BUCKET_BITS;
+    uint32_t sub = (uint32_t)(value >> shift) - HIST_SUB_BUCKETS;
+
+    return ((shift + 1) << HIST_SUB_BUCKET_BITS) + sub;
+}
+
+static inline uint64_t bucket_upper_bound(uint32_t index)
+{
+    if(index < HIST_SUB_BUCKETS) return index;
+
+    uint32_t shift = (index >> HIST_SUB_BUCKET_BITS) - 1;
+    uint64_t sub = index & (HIST_SUB_BUCKETS - 1);
+
+    return ((HIST_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void latency_histogram_init(latency_histogram_t *hist)
+{
+    hist->count.store(0, std::memory_order_relaxed);
+    hist->sum_ns.store(0, std::memory_order_relaxed);
+    hist->min_ns.store(UINT64_MAX, std::memory_order_relaxed);
+    hist->max_ns.store(0, std::memory_order_relaxed);
+    hist->overflow.store(0, std::memory_order_relaxed);
+    for(int i = 0; i < HIST_NUM_BUCKETS; i++)
+        hist->buckets[i].store(0, std::memory_order_relaxed);
+}
+
+void latency_histogram_record(latency_histogram_t *hist, uint64_t value_ns)
+{
+    // Single writer, so plain load/store pairs are enough and avoid atomic RMW cost
+    if(value_ns > HIST_MAX_VALUE_NS)
+    {
+        hist->overflow.store(hist->overflow.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        value_ns = HIST_MAX_VALUE_NS;
+    }
+
+    std::atomic<uint32_t> *bucket = &hist->buckets[bucket_index(value_ns)];
+    bucket->store(bucket->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if(value_ns < hist->min_ns.load(std::memory_order_relaxed)) hist->min_ns.store(value_ns, std::memory_order_relaxed);
+    if(value_ns > hist->max_ns.load(std::memory_order_relaxed)) hist->max_ns.store(value_ns, std::memory_order_relaxed);
+    hist->sum_ns.store(hist->sum_ns.load(std::memory_order_relaxed) + value_ns, std::memory_order_relaxed);
+
+    // Count is published last so a reader never sees more samples than bucket entries
+    hist->count.store(hist->count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+uint64_t latency_histogram_percentile(const latency_histogram_t *hist, double percentile)
+{
+    uint64_t count = hist->count.load(std::memory_order_acquire);
+    uint64_t target, seen = 0;
+
+    if(count == 0) return 0;
+
+    target = (uint64_t)((percentile / 100.0) * (double)count);
+    if(target >= count) target = count - 1;
+
+    for(uint32_t i = 0; i < HIST_NUM_BUCKETS; i++)
+    {
+        seen += hist->buckets[i].load(std::memory_order_relaxed);
+        if(seen > target)
+        {
+            uint64_t bound = bucket_upper_bound(i);
+            uint64_t max = hist->max_ns.load(std::memory_order_relaxed);
+            return (bound < max) ? bound : max;
+        }
+    }
+
+    return hist->max_ns.load(std::memory_order_relaxed);
+}
+
+void latency_histogram_print(FILE *out, const char *name, const latency_histogram_t *hist)
+{
+    uint64_t count = hist->count.load(std::memory_order_acquire);
+
+    if(count == 0)
+    {
+        fprintf(out, "%-28s no samples\n", name);
+        return;
+    }
+
+    fprintf(out, "%-28s n=%-8llu min=%9.1f mean=%9.1f p50=%9.1f p99=%9.1f p99.9=%9.1f max=%9.1f usec%s\n",
+            name, (unsigned long long)count,
+            hist->min_ns.load(std::memory_order_relaxed) / 1000.0,
+            (hist->sum_ns.load(std::memory_order_relaxed) / (double)count) / 1000.0,
+            latency_histogram_percentile(hist, 50.0) / 1000.0,
+            latency_histogram_percentile(hist, 99.0) / 1000.0,
+            latency_histogram_percentile(hist, 99.9) / 1000.0,
+            hist->max_ns.load(std::memory_order_relaxed) / 1000.0,
+            hist->overflow.load(std::memory_order_relaxed) ? " (overflow)" : "");
+}
@@ -0,0 +1,67 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    latency_histogram.h
+ * @brief   This file contains declaration of the fixed memory log bucketed latency histogram
+ * @date    18th October 2026
+ *
+ * Values are bucketed HdrHistogram style: every power of two range is split into
+ * HIST_SUB_BUCKETS linear sub buckets, so the relative error of any percentile is
+ * below 1/HIST_SUB_BUCKETS (~1.6%) from nanoseconds up to HIST_MAX_VALUE_NS.
+ *
+ * Recording is lock-free and wait-free for a single writer thread, readers may
+ * take percentiles at any time from another thread.
+ */
+
+#ifndef _LATENCY_HISTOGRAM_H
+#define _LATENCY_HISTOGRAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+
+#define HIST_SUB_BUCKET_BITS (6)
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BUCKET_BITS)
+#define HIST_MAX_MSB (35)                                   // 2^36 nsec ~ 68 sec
+#define HIST_MAX_VALUE_NS ((1ULL << (HIST_MAX_MSB + 1)) - 1)
+#define HIST_NUM_BUCKETS ((HIST_MAX_MSB - HIST_SUB_BUCKET_BITS + 2) * HIST_SUB_BUCKETS)
+
+typedef struct
+{
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum_ns;
+    std::atomic<uint64_t> min_ns;
+    std::atomic<uint64_t> max_ns;
+    std::atomic<uint64_t> overflow;
+    std::atomic<uint32_t> buckets[HIST_NUM_BUCKETS];
+} latency_histogram_t;
+
+/*
+ * @brief Function to reset the histogram, not safe against a concurrent writer
+ */
+void latency_histogram_init(latency_histogram_t *hist);
+
+/*
+ * @brief Function to record one value in nanoseconds, only one thread may record into a histogram
+ */
+void latency_histogram_record(latency_histogram_t *hist, uint64_t value_ns);
+
+/*
+ * @brief Function to get the upper bound of the bucket holding the given percentile (0 - 100)
+ */
+uint64_t latency_histogram_percentile(const latency_histogram_t *hist, double percentile);
+
+/*
+ * @brief Function to print count/min/mean/p50/p99/p99.9/max of the histogram in microseconds
+ */
+void latency_histogram_print(FILE *out, const char *name, const latency_histogram_t *hist);
+
+#endif
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <pthread.h>
 #include <sched.h>
@@ -20,25 +21,36 @@
 #include <syslog.h>
 
 #include <errno.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "capture.h"
+#include "frame_pipeline.h"
+#include "v4l2_capture.h"
 #include "motor.h"
 #include "ultrasonic_sensor.h"
+#include "rt_time.h"
+#include "jitter_stats.h"
+#include "service_stats.h"
+#include "trace.h"
+#include "blackboard.h"
+#include "digital_input.h"
+#include "placement.h"
+#include "service.h"
+#include "degrade.h"
+#include "rt_memory.h"
+#include "record.h"
+#include "hal.h"
+#include "vehicle_sim.h"
 
 #define USEC_PER_MSEC (1000)
 #define NANOSEC_PER_SEC (1000000000)
-#define NUM_CPU_CORES (1)
+#define SEQUENCER_PERIOD_NS (NANOSEC_PER_SEC / SEQUENCER_FREQ_HZ)
+#define SEQUENCER_MAX_CATCHUP (4)   // cycles released back-to-back before skipping ahead
+#define SIM_SCENARIO_LIMIT_NS (30ULL * NANOSEC_PER_SEC)  // a stopping run that has not come to rest by then is ended
 
-#define NUM_THREADS (3+1)
-
-bool abortS=FALSE, abortS1=FALSE, abortS2=FALSE, abortS3=FALSE;
-struct timeval start_time_val;
-
-typedef struct
-{
-    int threadIdx;
-    unsigned long long sequencePeriods;
-} threadParams_t;
+bool seq_relative_mode = false;
+jitter_stats_t seq_jitter;
 
 void print_scheduler(void)
 {
@@ -64,33 +76,47 @@ void print_scheduler(void)
 
 void intHandler(int arg)
 {
-    // Abort the sequencer itself
-    abortS=TRUE; abortS1=TRUE; abortS2=TRUE; abortS3=TRUE;
+    (void)arg;
+
+    // Abort the sequencer, the services follow once it posts their last release
+    blackboard_request_shutdown();
 }
 
-void *sequencer(void *threadp)
+// In a replay the sequencer delivers the recorded button events and ends the run after the recording
+static void sequencer_replay_step(void)
 {
-    struct timeval current_time_val;
-    struct timespec delay_time = {0,8333333}; // delay for 8.33 msec, 120 Hz
-    struct timespec remaining_time;
-    double current_time;
+    input_replay_advance();
+    if(replay_done()) blackboard_request_shutdown();
+}
+
+/*
+ * Legacy sequencer, sleeps a relative 8.33 msec each cycle. Processing time and
+ * wakeup latency add up on every cycle, so the base clock drifts over time.
+ */
+static void sequencer_relative(void)
+{
+    struct timespec delay_time = {0, SEQUENCER_PERIOD_NS}; // delay for 8.33 msec, 120 Hz
+    struct timespec sleep_time, remaining_time;
+    rt_ns_t start_ns, last_wake_ns, wake_ns;
     double residual;
     int rc, delay_cnt=0;
     unsigned long long seqCnt=0;
-    threadParams_t *threadParams = (threadParams_t *)threadp;
 
-    gettimeofday(&current_time_val, (struct timezone *)0);
+    start_ns = last_wake_ns = rt_now();
 
     do
     {
         delay_cnt=0; residual=0.0;
+        sleep_time = delay_time;
 
         do
         {
-            rc=nanosleep(&delay_time, &remaining_time);
+            rc=nanosleep(&sleep_time, &remaining_time);
 
-            if(rc == EINTR)
+            if((rc < 0) && (errno == EINTR))
             { 
+                // Only sleep what the signal cut short, not a whole period again
+                sleep_time = remaining_time;
                 residual = remaining_time.tv_sec + ((double)remaining_time.tv_nsec / (double)NANOSEC_PER_SEC);
 
                 if(residual > 0.0) printf("residual=%lf, sec=%d, nsec=%d\n", residual, (int)remaining_time.tv_sec, (int)remaining_time.tv_nsec);
@@ -102,55 +128,313 @@ void *sequencer(void *threadp)
                 perror("Sequencer nanosleep");
                 exit(-1);
             }
+            else
+            {
+                residual = 0.0;
+            }
            
         } while((residual > 0.0) && (delay_cnt < 100));
 
         seqCnt++;
-        gettimeofday(&current_time_val, (struct timezone *)0);
-        //syslog(LOG_INFO, "Sequencer cycle %llu @ sec=%d, msec=%d\n", seqCnt, (int)(current_time_val.tv_sec-start_time_val.tv_sec), (int)current_time_val.tv_usec/USEC_PER_MSEC);
-
+        wake_ns = rt_now();
+        jitter_stats_record(&seq_jitter, wake_ns - last_wake_ns - SEQUENCER_PERIOD_NS);
+        last_wake_ns = wake_ns;
 
         if(delay_cnt > 1) printf("Sequencer looping delay %d\n", delay_cnt);
 
-        // Release each service at a sub-rate of the generic sequencer rate
+        if(replay_active()) sequencer_replay_step();
+        service_release(seqCnt);
+
+    } while(!blackboard_shutdown_requested());
+
+    printf("Sequencer drift after %llu cycles: %lld usec\n", seqCnt,
+           (long long)(last_wake_ns - start_ns - (rt_ns_t)((seqCnt * NSEC_PER_SEC) / SEQUENCER_FREQ_HZ)) / NSEC_PER_MICROSEC);
+}
+
+/*
+ * Drift-free sequencer, sleeps until absolute release times on a timeline fixed at
+ * start, so the service phases do not move no matter how long the system runs.
+ * After an overrun the missed releases are issued back-to-back, but once the backlog
+ * exceeds SEQUENCER_MAX_CATCHUP cycles the sequencer skips ahead on the timeline.
+ */
+static void sequencer_absolute(void)
+{
+    struct timespec release_time;
+    rt_ns_t start_ns, release_ns, wake_ns;
+    unsigned long long seqCnt=0, target, skipped=0;
+    int rc;
+
+    start_ns = rt_now();
+
+    do
+    {
+        seqCnt++;
+
+        // Computed from the start on every cycle so rounding never accumulates
+        release_ns = start_ns + (seqCnt * NSEC_PER_SEC) / SEQUENCER_FREQ_HZ;
+        ns_to_timespec(release_ns, &release_time);
+
+        do
+        {
+            rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &release_time, NULL);
+        } while(rc == EINTR);
+
+        if(rc != 0)
+        {
+            errno = rc;
+            perror("Sequencer clock_nanosleep");
+            exit(-1);
+        }
+
+        wake_ns = rt_now();
+        jitter_stats_record(&seq_jitter, wake_ns - release_ns);
+
+        if(wake_ns - release_ns > SEQUENCER_MAX_CATCHUP * SEQUENCER_PERIOD_NS)
+        {
+            // Too far behind, jump to the current slot on the timeline
+            target = ((wake_ns - start_ns) * SEQUENCER_FREQ_HZ) / NSEC_PER_SEC;
+            skipped += target - seqCnt;
+            seqCnt = target;
+        }
+
+        if(replay_active()) sequencer_replay_step();
+        service_release(seqCnt);
+
+    } while(!blackboard_shutdown_requested());
+
+    if(skipped > 0) printf("Sequencer skipped %llu cycles after overruns\n", skipped);
+}
+
+/*
+ * Fast replay, the timeline moves one sequencer period per cycle without sleeping
+ * and the next cycle starts once every release of this one has completed, so the
+ * services see the same release pattern as in real time, only compressed.
+ */
+static void sequencer_replay_fast(void)
+{
+    rt_ns_t start_ns, stop_ns;
+    unsigned long long seqCnt=0;
+
+    start_ns = rt_now();
+
+    do
+    {
+        seqCnt++;
+        replay_set_elapsed((seqCnt * NSEC_PER_SEC) / SEQUENCER_FREQ_HZ);
+        sequencer_replay_step();
+        service_release(seqCnt);
+        service_wait_idle();
+    } while(!blackboard_shutdown_requested());
+
+    stop_ns = rt_now();
+    printf("Replayed %llu cycles at %.1fx real time\n", seqCnt,
+           ((double)seqCnt * NSEC_PER_SEC / SEQUENCER_FREQ_HZ) / (double)(stop_ns - start_ns));
+}
 
-        // Camera service = RT_MAX-1	@ 15 Hz
-        if((seqCnt % 8) == 0) sem_post(&sem_camera);
+// Stopping distance report of a simulated run, with the rates and priorities it ran at
+static void sim_scenario_report(FILE *out)
+{
+    char extra[512];
+    int len;
+    const latency_histogram_t *stop_latency = &event_latency[EVENT_OBSTACLE_STOP];
+
+    len = snprintf(extra, sizeof(extra), "\"rates_hz\":{");
+    for(int i = 0; i < NUM_SERVICES; i++)
+        len += snprintf(extra + len, sizeof(extra) - len, "%s\"%s\":%.1f", i ? "," : "", service_name(i),
+                        (double)SEQUENCER_FREQ_HZ / service_desc(i)->divisor);
+    len += snprintf(extra + len, sizeof(extra) - len, "},\"priorities\":{");
+    for(int i = 0; i < NUM_SERVICES; i++)
+        len += snprintf(extra + len, sizeof(extra) - len, "%s\"%s\":%d", i ? "," : "", service_name(i),
+                        placement[service_desc(i)->placement].priority);
+    snprintf(extra + len, sizeof(extra) - len, "},\"obstacle_to_pwm_zero_us\":%.1f",
+             stop_latency->count.load() ? stop_latency->max_ns.load() / 1000.0 : 0.0);
+
+    vehicle_sim_report(out, extra);
+}
 
-        // Motor service = RT_MAX-2	@ 8 Hz
-        if((seqCnt % 15) == 0) sem_post(&sem_motor);
+void *sequencer(void *threadp)
+{
+    (void)threadp;
 
-        // Ultrasonic service = RT_MAX-3	@ 6 Hz
-        if((seqCnt % 20) == 0) sem_post(&sem_ultrasonic);
+    rt_memory_prefault_stack();
+    jitter_stats_init(&seq_jitter);
 
-    } while(!abortS);
+    if(replay_fast())
+        sequencer_replay_fast();
+    else if(seq_relative_mode)
+        sequencer_relative();
+    else
+        sequencer_absolute();
 
-    sem_post(&sem_camera); sem_post(&sem_motor); sem_post(&sem_ultrasonic);
-    abortS1=TRUE; abortS2=TRUE; abortS3=TRUE;
+    service_wake_all();
+
+    jitter_stats_print(seq_relative_mode ? "Sequencer period jitter (relative)" : "Sequencer release jitter (absolute)", &seq_jitter);
 
     pthread_exit((void *)0);
 }
 
 int i, rc, scope;
-cpu_set_t threadcpu;
-pthread_t threads[NUM_THREADS];
-threadParams_t threadParams[NUM_THREADS];
-pthread_attr_t rt_sched_attr[NUM_THREADS];
+pthread_t sequencer_thread;
+pthread_t input_thread;
+pthread_attr_t sequencer_attr;
 int rt_max_prio, rt_min_prio;
-struct sched_param rt_param[NUM_THREADS];
 struct sched_param main_param;
 pthread_attr_t main_attr;
 pid_t mainpid;
-bool is_obstacle_detected;
 
 int main( int argc, char *argv[] ) 
 {
-    cpu_set_t allcpuset;
+    pthread_attr_t input_attr;
+    sigset_t dumpset;
+    struct timespec dump_poll = {0, 100000000};
+    const char *trace_path = NULL;
+    const char *admission_trace = NULL;
+    degrade_mode_t shown_mode = DEGRADE_NONE;
+    bool use_deadline = false;
+    bool strict_memory = false, warmup_reported = false;
+    rt_ns_t warmup_end_ns;
+    unsigned int slowest_divisor = 1;
+    bool sim_echo = false;
+    int sim_echo_mm = 0;
+    int sim_wall_mm = -1;
+    bool sim_scenario = false, v4l2_selected = false;
+    vehicle_sim_result_t sim_result;
+    rt_ns_t sim_end_ns = 0;
+    const char *record_path = NULL, *replay_path = NULL;
+    char path_arg[256], mode_arg[16];
+    unsigned record_mb = RECORD_DEFAULT_SIZE_MB;
+    bool replay_as_fast = false;
+    uint64_t epoch_ns;
+    char v4l2_device[64], v4l2_format[16];
+    unsigned v4l2_buffers;
+    int opt;
+
+    placement_defaults();
+
+    while((opt = getopt(argc, argv, "rt:E:V:c:a:A:DMR:P:S:d:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'r':
+                seq_relative_mode = true;   // legacy relative nanosleep sequencer
+                break;
+            case 't':
+                trace_path = optarg;        // binary trace file instead of syslog
+                break;
+            case 'E':
+                sim_echo = true;            // simulated ultrasonic echo, negative = lost echo
+                sim_echo_mm = atoi(optarg);
+                break;
+            case 'V':
+                // device[,yuyv|mjpeg[,buffers]]
+                strcpy(v4l2_format, "yuyv");
+                v4l2_buffers = 4;
+                if((sscanf(optarg, "%63[^,],%15[^,],%u", v4l2_device, v4l2_format, &v4l2_buffers) < 1) ||
+                   ((strcmp(v4l2_format, "yuyv") != 0) && (strcmp(v4l2_format, "mjpeg") != 0)))
+                {
+                    printf("Bad -V argument %s\r\n", optarg);
+                    exit(-1);
+                }
+                setup_camera(CAMERA_BACKEND_V4L2, strdup(v4l2_device),
+                             (strcmp(v4l2_format, "mjpeg") == 0) ? V4L2_PIX_FMT_MJPEG : V4L2_PIX_FMT_YUYV, v4l2_buffers);
+                v4l2_selected = true;
+                break;
+            case 'c':
+                if(placement_load_file(optarg) < 0) exit(-1);   // per-thread cores and priority
+                break;
+            case 'a':
+                if(placement_parse(optarg) < 0) exit(-1);       // thread=cpulist[:priority]
+                break;
+            case 'A':
+                admission_trace = optarg;   // trace of a previous run to check schedulability against
+                break;
+            case 'D':
+                use_deadline = true;        // SCHED_DEADLINE services on their own timers, no sequencer
+                break;
+            case 'M':
+                strict_memory = true;       // abort on any allocation in a service after its warm-up
+                break;
+            case 'R':
+                // file[,size_mb]
+                if(sscanf(optarg, "%255[^,],%u", path_arg, &record_mb) < 1)
+                {
+                    printf("Bad -R argument %s\r\n", optarg);
+                    exit(-1);
+                }
+                record_path = strdup(path_arg);
+                break;
+            case 'P':
+                // file[,fast]
+                mode_arg[0] = '\0';
+                if(sscanf(optarg, "%255[^,],%15s", path_arg, mode_arg) < 1)
+                {
+                    printf("Bad -P argument %s\r\n", optarg);
+                    exit(-1);
+                }
+                replay_path = strdup(path_arg);
+                replay_as_fast = (strcmp(mode_arg, "fast") == 0);
+                break;
+            case 'S':
+                sim_wall_mm = atoi(optarg); // simulated vehicle driving at a wall, 0 for the default distance
+                break;
+            case 'd':
+                if(service_parse_divisor(optarg) < 0) exit(-1); // service=divisor of the 120 Hz sequencer
+                break;
+            default:
+                printf("Usage: %s [-r] [-t trace_file] [-E distance_mm] [-V device[,yuyv|mjpeg[,buffers]]] [-c placement_file] [-a thread=cpulist[:priority]] [-A trace_file] [-D] [-M] [-R file[,size_mb]] [-P file[,fast]] [-S wall_mm] [-d service=divisor]\r\n", argv[0]);
+                printf("  -r  use the legacy relative sleep sequencer\r\n");
+                printf("  -t  write the service trace to a binary file (see trace_decode)\r\n");
+                printf("  -E  simulate the ultrasonic echo at a fixed distance in mm\r\n");
+                printf("  -V  capture with the native V4L2 mmap backend instead of OpenCV\r\n");
+                printf("  -c  load thread cores and priorities from a file, lines of <thread> <cpulist> <priority>\r\n");
+                printf("  -a  place one thread (sequencer, camera, motor, ultrasonic, input, housekeeping), repeatable\r\n");
+                printf("  -A  refuse to start when the services could miss deadlines with the execution times of a trace\r\n");
+                printf("  -D  run the services as SCHED_DEADLINE tasks instead of from the sequencer, budgets from the -A trace if given\r\n");
+                printf("  -M  abort on a heap allocation in a service after its warm-up instead of counting it\r\n");
+                printf("  -R  record the echo pings, button events, frames and motor commands to a file (see record_inspect)\r\n");
+                printf("  -P  replay the inputs of a recording instead of the hardware, in real time or as fast as possible\r\n");
+                printf("  -S  drive the simulated vehicle at a wall, print the stopping distance and exit\r\n");
+                printf("  -d  release one service (camera, motor, ultrasonic) every divisor sequencer cycles, repeatable\r\n");
+                exit(-1);
+        }
+    }
 
     printf("Welcome to Pi Parking System\r\n");
+    if(placement_validate() < 0) exit(-1);
+    if(replay_path && use_deadline)
+    {
+        // The replay timeline is advanced by the sequencer
+        printf("-P cannot be combined with -D\r\n");
+        exit(-1);
+    }
+    if(use_deadline)
+    {
+        // The kernel runs its own admission test on the budgets, the FIFO analysis does not apply
+        if(service_use_deadline(admission_trace) < 0) exit(-1);
+    }
+    else if(admission_trace && !service_admission_check(stdout, admission_trace, 0.0)) exit(-1);
+    // Lock before any thread exists so every stack and mapping from here on is resident
+    if(rt_memory_init(strict_memory) < 0) exit(-1);
+    // Mapped after locking so the files stay out of the locked memory
+    if(record_path && (record_open(record_path, (uint64_t)record_mb << 20) < 0)) exit(-1);
+    if(replay_path)
+    {
+        if(replay_open(replay_path, replay_as_fast) < 0) exit(-1);
+        setup_camera(CAMERA_BACKEND_REPLAY, NULL, 0, 0);
+        service_set_lockstep(replay_as_fast);
+    }
+    // A replay or a stopping run needs no hardware, the motors then drive the vehicle model
+    if(hal_select(((sim_wall_mm >= 0) || replay_path) ? HAL_BACKEND_SIM : hal_default_backend()) < 0) exit(-1);
+    if(hal_simulated())
+    {
+        vehicle_sim_init((sim_wall_mm > 0) ? sim_wall_mm : VEHICLE_SIM_DEFAULT_WALL_MM, ULTRASONIC_STOP_DISTANCE_MM);
+        if(!replay_path && !v4l2_selected) setup_camera(CAMERA_BACKEND_SIM, NULL, 0, 0);
+        sim_scenario = !replay_path && !sim_echo;
+    }
+    blackboard_init();
     
     setup_gpio();
-    setup_ultasonic_sensor();
+    setup_ultasonic_sensor(sim_echo, sim_echo_mm);
     openlog("pi-parking", 0, LOG_USER);
     syslog(LOG_INFO, "starting");
     
@@ -159,19 +443,15 @@ int main( int argc, char *argv[] )
     act.sa_handler = intHandler;
     sigaction(SIGINT, &act, NULL);
 
-    CPU_ZERO(&allcpuset);
-
-    for(i=0; i < NUM_CPU_CORES; i++)
-        CPU_SET(i, &allcpuset);
-
-    printf("Using CPUS=%d from total available.\r\n", CPU_COUNT(&allcpuset));
+    /* Dump the service statistics with SIGUSR1, handled by the main thread only */
+    sigemptyset(&dumpset);
+    sigaddset(&dumpset, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &dumpset, NULL);
+    service_stats_init();
 
-
-    // initialize the sequencer semaphores
-    //
-    if (sem_init (&sem_camera, 0, 0)) { printf ("Failed to initialize sem_camera\r\n"); exit (-1); }
-    if (sem_init (&sem_motor, 0, 0)) { printf ("Failed to initialize sem_motor\r\n"); exit (-1); }
-    if (sem_init (&sem_ultrasonic, 0, 0)) { printf ("Failed to initialize sem_ultrasonic\r\n"); exit (-1); }
+    // Main and the non-RT helper threads it starts stay off the control core
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &placement[PLACE_HOUSEKEEPING].cpus);
+    if(trace_start(trace_path) != 0) exit(-1);
 
     mainpid=getpid();
 
@@ -196,81 +476,110 @@ int main( int argc, char *argv[] )
     printf("rt_max_prio=%d\r\n", rt_max_prio);
     printf("rt_min_prio=%d\r\n", rt_min_prio);
 
-    for(i=0; i < NUM_THREADS; i++)
-    {
-
-      CPU_ZERO(&threadcpu);
-      CPU_SET(0, &threadcpu);
-
-      rc=pthread_attr_init(&rt_sched_attr[i]);
-      rc=pthread_attr_setinheritsched(&rt_sched_attr[i], PTHREAD_EXPLICIT_SCHED);
-      rc=pthread_attr_setschedpolicy(&rt_sched_attr[i], SCHED_FIFO);
-      rc=pthread_attr_setaffinity_np(&rt_sched_attr[i], sizeof(cpu_set_t), &threadcpu);
-
-      rt_param[i].sched_priority=rt_max_prio-i;
-      pthread_attr_setschedparam(&rt_sched_attr[i], &rt_param[i]);
-
-      threadParams[i].threadIdx=i;
-    }
-   
-    printf("Service threads will run on %d CPU cores\r\n", CPU_COUNT(&threadcpu));
-
-    // camera_service = RT_MAX-1 @ 15 Hz
-    //
-    rt_param[1].sched_priority=rt_max_prio-1;
-    pthread_attr_setschedparam(&rt_sched_attr[1], &rt_param[1]);
-    rc=pthread_create(&threads[1],               // pointer to thread descriptor
-                      &rt_sched_attr[1],         // use specific attributes
-                      //(void *)0,               // default attributes
-                      camera_service,                 // thread function entry point
-                      (void *)&(threadParams[1]) // parameters to pass in
-                     );
-    if(rc < 0)
-        perror("pthread_create for camera\r\n");
-    else
-        printf("pthread_create successful for camera\r\n");
-
-    // motor_service = RT_MAX-2	@ 8 Hz
-    //
-    rt_param[2].sched_priority=rt_max_prio-2;
-    pthread_attr_setschedparam(&rt_sched_attr[2], &rt_param[2]);
-    rc=pthread_create(&threads[2], &rt_sched_attr[2], motor_service, (void *)&(threadParams[2]));
-    if(rc < 0)
-        perror("pthread_create for motor\r\n");
-    else
-        printf("pthread_create successful for motor\r\n");
-
-    // ultrasonic_sensor_service = RT_MAX-3	@ 6 Hz
-    //
-    rt_param[3].sched_priority=rt_max_prio-3;
-    pthread_attr_setschedparam(&rt_sched_attr[3], &rt_param[3]);
-    rc=pthread_create(&threads[3], &rt_sched_attr[3], ultrasonic_sensor_service, (void *)&(threadParams[3]));
-    if(rc < 0)
-        perror("pthread_create for sensor failed\r\n");
-    else
-        printf("pthread_create successful for sensor\r\n");
+    // Service threads from the release table, policy, priority and cores come from the placement
+    if(service_start_all() < 0) exit(-1);
 
     // Wait for service threads to initialize and await release by sequencer.
     usleep(1000000);
+
+    // Input thread, sporadic, wakes the consuming service on each debounced edge
+    pthread_attr_init(&input_attr);
+    placement_set_attr(PLACE_INPUT, &input_attr);
+    rt_memory_stack_attr(&input_attr);
+    if(input_start(&input_attr, &input_thread) < 0) exit(-1);
+
+    // Both timelines start here, a replay lines up the recorded start with this one
+    epoch_ns = rt_now();
+    record_append(RECORD_STREAM_EPOCH, 0, epoch_ns, NULL, 0, NULL, 0);
+    if(replay_path) replay_start(epoch_ns);
  
-    // Create Sequencer thread
-    printf("Start sequencer\n");
-
-    // Sequencer = RT_MAX	@ 120 Hz
-    //
-    rt_param[0].sched_priority=rt_max_prio;
-    pthread_attr_setschedparam(&rt_sched_attr[0], &rt_param[0]);
-    rc=pthread_create(&threads[0], &rt_sched_attr[0], sequencer, (void *)&(threadParams[0]));
-    if(rc < 0)
-        perror("pthread_create for scheduler service 0");
-    else
-        printf("pthread_create successful for scheduler service 0\n");
+    // Create Sequencer thread, deadline mode services release themselves
+    if(!use_deadline)
+    {
+        printf("Start sequencer\n");
+
+        // Sequencer @ 120 Hz, highest priority on the control core by default
+        //
+        pthread_attr_init(&sequencer_attr);
+        placement_set_attr(PLACE_SEQUENCER, &sequencer_attr);
+        rt_memory_stack_attr(&sequencer_attr);
+        rc=pthread_create(&sequencer_thread, &sequencer_attr, sequencer, NULL);
+        if(rc != 0)
+            printf("pthread_create for sequencer failed\r\n");
+        else
+            printf("pthread_create successful for sequencer\n");
+    }
         
+   // Drop the main thread out of the RT class, it only serves statistics dumps from here on
+   main_param.sched_priority=0;
+   pthread_setschedparam(pthread_self(), SCHED_OTHER, &main_param);
+
+   // Read the placement back from the kernel, not from the config
+   printf("Effective placement:\r\n");
+   if(!use_deadline) placement_print_thread(stdout, placement[PLACE_SEQUENCER].name, sequencer_thread);
+   service_print_placement(stdout);
+   if(!replay_path) placement_print_thread(stdout, placement[PLACE_INPUT].name, input_thread);
+   placement_print_thread(stdout, placement[PLACE_HOUSEKEEPING].name, pthread_self());
+   rt_memory_report(stdout, "thread startup");
+
+   // Report once the slowest service is past its warm-up releases, one second late to be sure
+   for(i = 0; i < NUM_SERVICES; i++)
+       if(service_desc(i)->divisor > slowest_divisor) slowest_divisor = service_desc(i)->divisor;
+   warmup_end_ns = rt_now() + (uint64_t)(RT_MEMORY_WARMUP_RELEASES * slowest_divisor / SEQUENCER_FREQ_HZ + 1) * NSEC_PER_SEC;
+   if(sim_scenario) sim_end_ns = rt_now() + SIM_SCENARIO_LIMIT_NS;
+
+   while(!blackboard_shutdown_requested())
+   {
+       if(sigtimedwait(&dumpset, NULL, &dump_poll) == SIGUSR1)
+       {
+           service_stats_dump(stdout);
+           frame_pipeline_dump(stdout);
+           degrade_dump(stdout);
+           rt_memory_report(stdout, "since the last report");
+           service_memory_dump(stdout);
+       }
+
+       if(!warmup_reported && (rt_now() >= warmup_end_ns))
+       {
+           rt_memory_report(stdout, "warm-up");
+           warmup_reported = true;
+       }
+
+       // The policy runs on the sequencer, report its mode changes from here
+       if(degrade_mode() != shown_mode)
+       {
+           shown_mode = degrade_mode();
+           printf("Degradation mode: %s\r\n", degrade_mode_name(shown_mode));
+           syslog(LOG_WARNING, "degradation mode %s", degrade_mode_name(shown_mode));
+       }
+
+       // A stopping run ends once the vehicle is at rest in front of or against the wall
+       if(sim_scenario)
+       {
+           vehicle_sim_result(&sim_result);
+           if(sim_result.settled || (rt_now() >= sim_end_ns)) blackboard_request_shutdown();
+       }
+   }
+
    printf("Joining threads \r\n");
 
 
-   for(i=0;i<NUM_THREADS;i++)
-       pthread_join(threads[i], NULL);
+   if(use_deadline)
+       service_wake_all();
+   else
+       pthread_join(sequencer_thread, NULL);
+   service_join_all();
+
+   input_stop();
+   trace_stop();
+   record_close(stdout);
+   replay_close();
+   service_stats_dump(stdout);
+   frame_pipeline_dump(stdout);
+   degrade_dump(stdout);
+   rt_memory_report(stdout, "steady state");
+   service_memory_dump(stdout);
+   if(sim_scenario) sim_scenario_report(stdout);
 
    printf("TEST COMPLETE\n");
    return 0;
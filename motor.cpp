@@ -16,115 +16,162 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <syslog.h>
-#include <wiringPi.h>
+#include <unistd.h>
 #include <semaphore.h>
 #include <pthread.h>
 
 #include "motor.h"
-#include "time_stamp.h"
-
-sem_t sem_motor;
-bool is_forward = true;
-bool is_reverse = false;
-extern bool abortS2;
-
-// GPIO pin definitions
-#define MOTOR_PWM_A 1  // PWM for Motor A (GPIO 18)
-#define MOTOR_IN1_A 4  // Direction IN1 for Motor A (GPIO 23)
-#define MOTOR_IN2_A 5  // Direction IN2 for Motor A (GPIO 24)
-#define MOTOR_PWM_B 23 // PWM for Motor B (GPIO 13)
-#define MOTOR_IN1_B 3  // Direction IN1 for Motor B (GPIO 22, WiringPi pin 3)
-#define MOTOR_IN2_B 2  // Direction IN2 for Motor B (GPIO 27, WiringPi pin 2)
-#define STBY_PIN 6     // Standby pin (GPIO 25)
-#define BUTTON_PIN 7   // Button pin (GPIO 4, WiringPi pin 7)
+#include "capture.h"
+#include "rt_time.h"
+#include "service_stats.h"
+#include "blackboard.h"
+#include "ultrasonic_sensor.h"
+#include "hal.h"
+#include "digital_input.h"
+#include "service.h"
+#include "record.h"
+
+static pthread_mutex_t motor_lock;   // serializes motor commands from motor_service and the stop path
+
+static int last_speed[2] = { -1, -1 };    // PWM duty last written, under motor_lock
+static motor_cmd_t last_cmd = { { -1, -1 }, { -1, -1 } };   // last command applied, under motor_lock
+
+static input_queue_t button_queue;      // gear button events, consumed by motor_service
+static uint64_t range_max_age_ns;       // set up once the -d divisors are known
+static uint64_t rear_max_age_ns;
+
+static const motor_cmd_t motor_cmd_stop = { { 0, 0 }, { 0, 0 } };
+static const motor_cmd_t motor_cmd_forward = { { MOTOR_FORWARD_DUTY, MOTOR_FORWARD_DUTY }, { 1, 1 } };
+static const motor_cmd_t motor_cmd_reverse = { { MOTOR_FORWARD_DUTY, MOTOR_FORWARD_DUTY }, { 0, 0 } };
+#define RANGE_MAX_AGE_PERIODS (3)               // ultrasonic periods, older readings do not count as clear
+#define REAR_RANGE_MAX_AGE_FRAMES (4)           // camera periods, older rear decisions do not count as clear
+
+// Runs on the input thread, release motor_service right away instead of at its next 8 Hz slot
+static void button_notify(void *arg)
+{
+    (void)arg;
+    service_wake(SERVICE_MOTOR);
+}
 
 // Initialize GPIO pins
 void setup_gpio() {
-    wiringPiSetup();
-    pinMode(BUTTON_PIN, INPUT);  // Set button pin as input
-    pullUpDnControl(BUTTON_PIN, PUD_UP);  // Enable pull-up resistor
-    pinMode(MOTOR_PWM_A, PWM_OUTPUT);
-    pinMode(MOTOR_IN1_A, OUTPUT);
-    pinMode(MOTOR_IN2_A, OUTPUT);
-    pinMode(MOTOR_PWM_B, PWM_OUTPUT);
-    pinMode(MOTOR_IN1_B, OUTPUT);
-    pinMode(MOTOR_IN2_B, OUTPUT);
-    pinMode(STBY_PIN, OUTPUT);
-    digitalWrite(STBY_PIN, HIGH);  // Take motor driver out of standby mode
+    pthread_mutexattr_t lock_attr;
+
+    // Priority inheritance so the stop path is never held up by a preempted motor_service
+    pthread_mutexattr_init(&lock_attr);
+    pthread_mutexattr_setprotocol(&lock_attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&motor_lock, &lock_attr);
+    pthread_mutexattr_destroy(&lock_attr);
+
+    range_max_age_ns = RANGE_MAX_AGE_PERIODS * (uint64_t)service_desc(SERVICE_ULTRASONIC)->divisor * NSEC_PER_SEC / SEQUENCER_FREQ_HZ;
+    rear_max_age_ns = REAR_RANGE_MAX_AGE_FRAMES * (uint64_t)service_desc(SERVICE_CAMERA)->divisor * NSEC_PER_SEC / SEQUENCER_FREQ_HZ;
+
+    // Pins, PWM and the button line belong to the hardware backend
+    if(hal()->setup() < 0)
+    {
+        printf("Failed to set up the %s hardware\r\n", hal()->name);
+        exit(-1);
+    }
+
+    input_queue_init(&button_queue);
+    if(hal()->add_button(&button_queue, button_notify, NULL) < 0)
+    {
+        printf("Failed to open the button line\r\n");
+        exit(-1);
+    }
 }
 
-// Control motor speed and direction
-void control_motor(int motor, int speed, int direction) {
-    if (motor == 1) {  // Motor A
-        pwmWrite(MOTOR_PWM_A, speed);
-        digitalWrite(MOTOR_IN1_A, direction ? HIGH : LOW);
-        digitalWrite(MOTOR_IN2_A, direction ? LOW : HIGH);
-    } else if (motor == 2) {  // Motor B
-        pwmWrite(MOTOR_PWM_B, speed);
-        digitalWrite(MOTOR_IN1_B, direction ? HIGH : LOW);
-        digitalWrite(MOTOR_IN2_B, direction ? LOW : HIGH);
+static void motor_write_pwm(int motor, int speed)
+{
+    // PWM sits on its own peripheral, only touch it when the duty changes
+    if(speed == last_speed[motor]) return;
+    hal()->motor_pwm(motor, speed);
+    last_speed[motor] = speed;
+}
+
+// Apply a motor command, motor_lock must be held
+static void motor_apply_locked(const motor_cmd_t *cmd)
+{
+    // Slow down before the direction changes and speed up only after it
+    for(int m = 0; m < 2; m++)
+        if(cmd->speed[m] < last_speed[m]) motor_write_pwm(m, cmd->speed[m]);
+
+    hal()->motor_direction(cmd->direction);
+
+    for(int m = 0; m < 2; m++)
+        motor_write_pwm(m, cmd->speed[m]);
+
+    // Only the changes are recorded, they are what a replay is compared on
+    if(record_enabled() && (memcmp(cmd, &last_cmd, sizeof(last_cmd)) != 0))
+    {
+        record_motor_t change = { { cmd->speed[0], cmd->speed[1] }, { cmd->direction[0], cmd->direction[1] }, service_cycle() };
+        record_append(RECORD_STREAM_MOTOR, 0, rt_now(), &change, sizeof(change), NULL, 0);
     }
+    last_cmd = *cmd;
+}
+
+void motor_apply(const motor_cmd_t *cmd) {
+    pthread_mutex_lock(&motor_lock);
+    motor_apply_locked(cmd);
+    pthread_mutex_unlock(&motor_lock);
 }
 
-void *motor_service(void *threadp)
+// Stop both motors without waiting for the next motor_service release
+void motor_emergency_stop(event_latency_id_t latency_id, uint64_t detection_ns) {
+    motor_apply(&motor_cmd_stop);
+
+    service_stats_event_latency(latency_id, detection_ns);
+}
+
+void motor_release(uint64_t start_ns, uint32_t seq)
 {
-    struct timespec start = {0,0};
-    struct timespec stop = {0,0};
-    static struct timespec wcet = {0,0};
-    struct timespec time_taken = {0,0};
-    int button_state = 0;
-    unsigned long motor_service_count = 0;
-    printf("Motor started\r\n");
-		
-    while(!abortS2)
+    vehicle_snapshot_t snap;
+    input_event_t event;
+
+    (void)start_ns;
+    (void)seq;
+
+    // Each press toggles the gear once, no matter how long it is held
+    while(input_queue_pop(&button_queue, &event))
     {
-        sem_wait(&sem_motor);
-	clock_gettime(CLOCK_REALTIME, &start);
-        button_state = digitalRead(BUTTON_PIN);  // Read button state
-        if (button_state == 1) {  // Button is pressed
-		is_forward = !is_forward;  // Toggle forward state
-		is_reverse = !is_reverse;  // Toggle reverse state
-	}
-	if(is_forward | is_reverse)
-	{
-		if(is_forward)
-		{
-			// Test Motor A
-			control_motor(1, 512, 1);  // Half speed forward
-			// Test Motor B
-			control_motor(2, 512, 1);  // Half speed forward
-		}
-		else if(is_reverse)
-		{
-			control_motor(1, 512, 0);  // Half speed backward
-			control_motor(2, 512, 0);  // Half speed backward
-		}
-	}
-	
-	if(is_obstacle_detected)
-	{
-		control_motor(1, 0, 0);    // Stop Motor A
-		control_motor(2, 0, 0);    // Stop Motor B
-	}
-	clock_gettime( CLOCK_REALTIME, &stop);
-	delta_t(&stop, &start, &time_taken);
-	motor_service_count++;
-	if(check_wcet(&time_taken, &wcet))
-	{
-	    syslog(LOG_INFO, "motor wcet: %lu sec, %lu msec (%lu microsec), ((%lu nanosec))\n\n", wcet.tv_sec, (wcet.tv_nsec / NSEC_PER_MSEC), (wcet.tv_nsec / NSEC_PER_MICROSEC),wcet.tv_nsec);
-	}
-	syslog(LOG_CRIT, "motor_service_count = %lu , timestamp: %lu sec, %lu msec (%lu microsec), ((%lu nanosec))\n\n", motor_service_count, wcet.tv_sec, (wcet.tv_nsec / NSEC_PER_MSEC), (wcet.tv_nsec / NSEC_PER_MICROSEC),wcet.tv_nsec);
+        if(event.type != INPUT_EVENT_PRESS) continue;
+        blackboard_set_gear((blackboard_gear() == GEAR_FORWARD) ? GEAR_REVERSE : GEAR_FORWARD, event.timestamp_ns);
+        camera_gear_changed(event.timestamp_ns);     // Bring the camera out of standby without waiting for its release
     }
-	
-        
-    delay(500);
 
-    control_motor(1, 0, 0);    // Stop Motor A
+    // The stop path may already have stopped the motors, reconcile with the
+    // current state under the lock instead of driving first and stopping after
+    pthread_mutex_lock(&motor_lock);
+    blackboard_snapshot(&snap);
+    if(blackboard_obstacle_in_path(&snap) ||
+       ((snap.gear.gear == GEAR_FORWARD) && (rt_now() - snap.front.measured_ns > range_max_age_ns)) ||
+       ((snap.gear.gear == GEAR_REVERSE) && ((snap.rear.measured_ns < snap.gear.changed_ns) ||
+                                             (rt_now() - snap.rear.measured_ns > rear_max_age_ns) ||
+                                             ((snap.ranges.fitted_mask & (1u << ULTRASONIC_REAR)) &&
+                                              (rt_now() - snap.ranges.measured_ns[ULTRASONIC_REAR] > range_max_age_ns)))))
+    {
+        // Obstacle in the way, or a sensor facing the gear has not answered recently.
+        // A rear decision from before the switch to reverse was made in an earlier session
+        motor_apply_locked(&motor_cmd_stop);
+    }
+    else if(snap.gear.gear == GEAR_FORWARD)
+    {
+        motor_apply_locked(&motor_cmd_forward);
+    }
+    else
+    {
+        motor_apply_locked(&motor_cmd_reverse);
+    }
+    pthread_mutex_unlock(&motor_lock);
+}
 
-    control_motor(2, 0, 0);    // Stop Motor B
+void motor_fini(void)
+{
+    usleep(500000);
+    motor_apply(&motor_cmd_stop);
 
     syslog(LOG_INFO, "Motor stopped\r\n");
-    
-    pthread_exit(NULL);
 }
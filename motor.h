@@ -17,10 +17,12 @@
 
 #include <stdio.h>
 #include <stdint.h>
-#include <wiringPi.h>
 
-extern bool is_obstacle_detected;
-extern sem_t sem_motor;
+#include "service_stats.h"
+
+#define MOTOR_FORWARD_DUTY (512)           // half speed, forward and reverse
+#define MOTOR_FULL_DUTY_SPEED_MM_S (800)   // floor speed at duty 1023, calibrate per vehicle
+#define MOTOR_BRAKE_TAU_S (0.08)           // time constant of the speed decay at duty 0
 
 /*
  * @brief Function to setup GPIOs for motor
@@ -28,13 +30,33 @@ extern sem_t sem_motor;
 void setup_gpio();
 
 /*
- * @brief Function to trigger the specified motor to move at the specified speed in the specific direction
+ * @brief Speed and direction of both motors, applied together by motor_apply
+ */
+typedef struct
+{
+    int speed[2];        // PWM duty of motor A and B, 0 to 1023
+    int direction[2];    // 1 forward, 0 backward
+} motor_cmd_t;
+
+/*
+ * @brief Function to apply a command to both motors at once, direction pins change in a single register write when /dev/gpiomem is mapped
+ */
+void motor_apply(const motor_cmd_t *cmd);
+
+/*
+ * @brief Function to stop both motors right away from any thread, detection_ns is when the obstacle was seen
+ *        and latency_id the histogram the detection to stop latency goes to
+ */
+void motor_emergency_stop(event_latency_id_t latency_id, uint64_t detection_ns);
+
+/*
+ * @brief One motor service release, applies gear changes and moves or stops the motors based on the gear/sensor status
  */
-void control_motor(int motor, int speed, int direction);
+void motor_release(uint64_t start_ns, uint32_t seq);
 
 /*
- * @brief Motor service to move the motor in the direction based on the gear status/sensor status
+ * @brief Function to stop the motors once the motor service is shut down
  */
-void *motor_service(void *threadp);
+void motor_fini(void);
 
 
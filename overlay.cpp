@@ -0,0 +1,225 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    overlay.cpp
+ * @brief   This file contains definition of the parking guide and distance overlay compositor
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "overlay.h"
+#include "blackboard.h"
+#include "ultrasonic_sensor.h"
+
+using namespace cv;
+
+#define GUIDE_ALPHA (180)
+#define GUIDE_THICKNESS (3)
+#define TEXT_HEIGHT (40)
+#define TEXT_BACKGROUND_ALPHA (120)
+
+/*
+ * Turn a color image and its alpha mask into a layer covering only the pixels
+ * the alpha touches, with the color premultiplied and the alpha inverted
+ */
+static void layer_build(overlay_layer_t *layer, const Mat &color, const Mat &alpha, Point origin)
+{
+    Rect box = boundingRect(alpha);
+
+    layer->roi = Rect(origin.x + box.x, origin.y + box.y, box.width, box.height);
+    layer->color.create(box.size(), CV_8UC3);
+    layer->inv_alpha.create(box.size(), CV_8UC3);
+
+    for(int y = 0; y < box.height; y++)
+    {
+        const uchar *c = color.ptr<uchar>(box.y + y) + box.x * 3;
+        const uchar *a = alpha.ptr<uchar>(box.y + y) + box.x;
+        uchar *pc = layer->color.ptr<uchar>(y);
+        uchar *ia = layer->inv_alpha.ptr<uchar>(y);
+
+        for(int x = 0; x < box.width; x++)
+        {
+            for(int ch = 0; ch < 3; ch++)
+            {
+                pc[x * 3 + ch] = (uchar)((c[x * 3 + ch] * a[x] + 127) / 255);
+                ia[x * 3 + ch] = (uchar)(255 - a[x]);
+            }
+        }
+    }
+}
+
+// Guide geometry shared by the precomputed layer and the naive reference
+static void draw_guides(Mat &color, Mat *alpha, Size size)
+{
+    const int w = size.width, h = size.height;
+    const Point left_near(w * 20 / 100, h), left_far(w * 38 / 100, h * 45 / 100);
+    const Point right_near(w * 80 / 100, h), right_far(w * 62 / 100, h * 45 / 100);
+    const int marker_y[3] = { h * 90 / 100, h * 72 / 100, h * 55 / 100 };
+    const Scalar marker_color[3] = { Scalar(0, 0, 255), Scalar(0, 255, 255), Scalar(0, 255, 0) };
+
+    line(color, left_near, left_far, Scalar(0, 255, 0), GUIDE_THICKNESS, LINE_AA);
+    line(color, right_near, right_far, Scalar(0, 255, 0), GUIDE_THICKNESS, LINE_AA);
+    if(alpha)
+    {
+        line(*alpha, left_near, left_far, Scalar(GUIDE_ALPHA), GUIDE_THICKNESS, LINE_AA);
+        line(*alpha, right_near, right_far, Scalar(GUIDE_ALPHA), GUIDE_THICKNESS, LINE_AA);
+    }
+
+    // Distance markers span the guides at their height
+    for(int i = 0; i < 3; i++)
+    {
+        int xl = left_near.x + (left_far.x - left_near.x) * (h - marker_y[i]) / (h - left_far.y);
+        int xr = right_near.x + (right_far.x - right_near.x) * (h - marker_y[i]) / (h - right_far.y);
+
+        line(color, Point(xl, marker_y[i]), Point(xr, marker_y[i]), marker_color[i], GUIDE_THICKNESS, LINE_AA);
+        if(alpha)
+            line(*alpha, Point(xl, marker_y[i]), Point(xr, marker_y[i]), Scalar(GUIDE_ALPHA), GUIDE_THICKNESS, LINE_AA);
+    }
+}
+
+static void format_status(char *text, size_t len, int distance_mm, int status)
+{
+    if(distance_mm == OVERLAY_NO_SENSOR)
+        snprintf(text, len, "REVERSE  --  %s", (status == OVERLAY_STATUS_OBSTACLE) ? "OBSTACLE" : "CLEAR");
+    else if(distance_mm < 0)
+        snprintf(text, len, "REVERSE  --.- cm  %s", (status == OVERLAY_STATUS_OBSTACLE) ? "OBSTACLE" : "CLEAR");
+    else
+        snprintf(text, len, "REVERSE  %d.%d cm  %s", distance_mm / 10, distance_mm % 10,
+                 (status == OVERLAY_STATUS_OBSTACLE) ? "OBSTACLE" : "CLEAR");
+}
+
+void overlay_init(overlay_t *overlay, Size size)
+{
+    Mat color = Mat::zeros(size, CV_8UC3);
+    Mat alpha = Mat::zeros(size, CV_8UC1);
+
+    overlay->size = size;
+    draw_guides(color, &alpha, size);
+    layer_build(&overlay->guides, color, alpha, Point(0, 0));
+
+    // Text layer has a fixed footprint, its images are allocated here once
+    overlay->text_color_src = Mat::zeros(Size(size.width, TEXT_HEIGHT), CV_8UC3);
+    overlay->text_alpha_src = Mat::zeros(Size(size.width, TEXT_HEIGHT), CV_8UC1);
+    overlay->text.roi = Rect(0, 0, size.width, TEXT_HEIGHT);
+    overlay->text.color = Mat::zeros(Size(size.width, TEXT_HEIGHT), CV_8UC3);
+    overlay->text.inv_alpha = Mat(Size(size.width, TEXT_HEIGHT), CV_8UC3, Scalar(255, 255, 255));
+
+    // Impossible values so the first overlay_set_status renders
+    overlay->shown_distance_mm = -2;
+    overlay->shown_status = -1;
+}
+
+void overlay_set_status(overlay_t *overlay, int distance_mm, int status)
+{
+    char text[64];
+
+    if((distance_mm == overlay->shown_distance_mm) && (status == overlay->shown_status))
+        return;
+
+    format_status(text, sizeof(text), distance_mm, status);
+
+    overlay->text_color_src.setTo(Scalar(0, 0, 0));
+    overlay->text_alpha_src.setTo(Scalar(TEXT_BACKGROUND_ALPHA));
+    putText(overlay->text_color_src, text, Point(10, TEXT_HEIGHT - 12), FONT_HERSHEY_SIMPLEX, 0.8,
+            (status == OVERLAY_STATUS_OBSTACLE) ? Scalar(0, 0, 255) : Scalar(255, 255, 255), 2, LINE_AA);
+    putText(overlay->text_alpha_src, text, Point(10, TEXT_HEIGHT - 12), FONT_HERSHEY_SIMPLEX, 0.8, Scalar(255), 2, LINE_AA);
+
+    // Background covers the whole region, so the layer keeps its size and never reallocates
+    layer_build(&overlay->text, overlay->text_color_src, overlay->text_alpha_src, Point(0, 0));
+
+    overlay->shown_distance_mm = distance_mm;
+    overlay->shown_status = status;
+}
+
+/*
+ * d = d * inv_alpha / 255 + color over one row. Division by 255 is done exactly
+ * for 16 bit products as (x + 128 + ((x + 128) >> 8)) >> 8.
+ */
+static inline void blend_row(uchar *d, const uchar *color, const uchar *inv_alpha, int len)
+{
+    int i = 0;
+
+#if CV_SIMD128
+    const v_uint16x8 round = v_setall_u16(128);
+
+    for(; i <= len - 16; i += 16)
+    {
+        v_uint8x16 vd = v_load(d + i);
+        v_uint8x16 va = v_load(inv_alpha + i);
+        v_uint16x8 d0, d1, a0, a1;
+
+        v_expand(vd, d0, d1);
+        v_expand(va, a0, a1);
+        d0 = v_mul_wrap(d0, a0) + round;
+        d1 = v_mul_wrap(d1, a1) + round;
+        d0 = (d0 + (d0 >> 8)) >> 8;
+        d1 = (d1 + (d1 >> 8)) >> 8;
+
+        // Saturating add of the premultiplied color
+        v_store(d + i, v_pack(d0, d1) + v_load(color + i));
+    }
+#endif
+
+    for(; i < len; i++)
+    {
+        unsigned x = d[i] * inv_alpha[i] + 128;
+        unsigned v = ((x + (x >> 8)) >> 8) + color[i];
+        d[i] = (uchar)((v > 255) ? 255 : v);
+    }
+}
+
+void overlay_blend(Mat &frame, const overlay_layer_t *layer)
+{
+    Rect roi = layer->roi & Rect(0, 0, frame.cols, frame.rows);
+    int dx = roi.x - layer->roi.x, dy = roi.y - layer->roi.y;
+
+    if((roi.area() == 0) || (frame.type() != CV_8UC3)) return;
+
+    for(int y = 0; y < roi.height; y++)
+    {
+        blend_row(frame.ptr<uchar>(roi.y + y) + roi.x * 3,
+                  layer->color.ptr<uchar>(dy + y) + dx * 3,
+                  layer->inv_alpha.ptr<uchar>(dy + y) + dx * 3,
+                  roi.width * 3);
+    }
+}
+
+void overlay_stage(pipeline_frame_t *frame, void *arg)
+{
+    overlay_t *overlay = (overlay_t *)arg;
+    vehicle_snapshot_t snap;
+    int distance_mm;
+
+    if(frame->image.size() != overlay->size) return;
+
+    // The view looks backward, so does the distance
+    blackboard_snapshot(&snap);
+    distance_mm = (snap.ranges.fitted_mask & (1u << ULTRASONIC_REAR)) ? snap.ranges.distance_mm[ULTRASONIC_REAR] : OVERLAY_NO_SENSOR;
+    overlay_set_status(overlay, distance_mm, blackboard_obstacle_in_path(&snap) ? OVERLAY_STATUS_OBSTACLE : OVERLAY_STATUS_CLEAR);
+    overlay_blend(frame->image, &overlay->guides);
+    overlay_blend(frame->image, &overlay->text);
+}
+
+void overlay_draw_naive(Mat &frame, int distance_mm, int status)
+{
+    char text[64];
+
+    draw_guides(frame, NULL, frame.size());
+    format_status(text, sizeof(text), distance_mm, status);
+    putText(frame, text, Point(10, TEXT_HEIGHT - 12), FONT_HERSHEY_SIMPLEX, 0.8,
+            (status == OVERLAY_STATUS_OBSTACLE) ? Scalar(0, 0, 255) : Scalar(255, 255, 255), 2, LINE_AA);
+}
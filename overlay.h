@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    overlay.h
+ * @brief   This file contains declaration of the parking guide and distance overlay compositor
+ * @date    18th October 2026
+ *
+ * Layers are kept as a premultiplied color image plus an inverse alpha image,
+ * both replicated to 3 channels, so compositing is the same per byte operation
+ * dst = dst * (255 - a) / 255 + color * a / 255 over contiguous memory.
+ * The guide lines are rendered once per resolution, the status text only when
+ * the values it shows change.
+ */
+
+#ifndef _OVERLAY_H
+#define _OVERLAY_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+#include "frame_pipeline.h"
+
+#define OVERLAY_STATUS_CLEAR (0)
+#define OVERLAY_STATUS_OBSTACLE (1)
+#define OVERLAY_NO_SENSOR (-3)        // distance when no rear sensor is fitted, -1 is nothing in range
+
+typedef struct
+{
+    cv::Mat color;      // CV_8UC3, color already multiplied by alpha
+    cv::Mat inv_alpha;  // CV_8UC3, 255 - alpha on every channel
+    cv::Rect roi;       // bounding box of the non transparent pixels in frame coordinates
+} overlay_layer_t;
+
+typedef struct
+{
+    cv::Size size;
+    overlay_layer_t guides;
+    overlay_layer_t text;
+    cv::Mat text_color_src;    // scratch images the text is rendered into, sized once
+    cv::Mat text_alpha_src;
+    int shown_distance_mm;
+    int shown_status;
+} overlay_t;
+
+/*
+ * @brief Function to render the static guide lines for the frame size and reset the text layer
+ */
+void overlay_init(overlay_t *overlay, cv::Size size);
+
+/*
+ * @brief Function to set the values shown in the text region, re-renders the text only on change.
+ *        distance_mm is the rear range, -1 for nothing in range or OVERLAY_NO_SENSOR
+ */
+void overlay_set_status(overlay_t *overlay, int distance_mm, int status);
+
+/*
+ * @brief Function to blend one layer into the frame in place with the SIMD kernel
+ */
+void overlay_blend(cv::Mat &frame, const overlay_layer_t *layer);
+
+/*
+ * @brief Frame pipeline stage compositing the guides and status, arg is the overlay_t
+ */
+void overlay_stage(pipeline_frame_t *frame, void *arg);
+
+/*
+ * @brief Reference version drawing everything with cv::line/putText every frame, used by bench_overlay
+ */
+void overlay_draw_naive(cv::Mat &frame, int distance_mm, int status);
+
+#endif
@@ -0,0 +1,300 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    placement.cpp
+ * @brief   This file contains definition of the CPU affinity and priority placement of the RT threads
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "placement.h"
+#include "sched_deadline.h"
+
+#define SYS_CPU_DIR "/sys/devices/system/cpu/"
+
+thread_placement_t placement[NUM_PLACEMENTS];
+
+static const char *placement_names[NUM_PLACEMENTS] = { "sequencer", "camera", "motor", "ultrasonic", "input", "housekeeping" };
+
+static cpu_set_t online_cpus, isolated_cpus, nohz_cpus;
+
+// Parse a kernel cpulist such as "0-2,4", an empty list or "(null)" gives an empty set
+static int parse_cpulist(const char *list, cpu_set_t *set)
+{
+    const char *p = list;
+    char *end;
+    long first, last;
+
+    CPU_ZERO(set);
+    while(isspace((unsigned char)*p)) p++;
+    if((*p == '\0') || (*p == '(')) return 0;
+
+    for(;;)
+    {
+        first = strtol(p, &end, 10);
+        if((end == p) || (first < 0)) return -1;
+        last = first;
+        p = end;
+        if(*p == '-')
+        {
+            p++;
+            last = strtol(p, &end, 10);
+            if((end == p) || (last < first)) return -1;
+            p = end;
+        }
+        if(last >= CPU_SETSIZE) return -1;
+        for(long cpu = first; cpu <= last; cpu++) CPU_SET(cpu, set);
+
+        if(*p != ',') break;
+        p++;
+    }
+
+    while(isspace((unsigned char)*p)) p++;
+    return (*p == '\0') ? 0 : -1;
+}
+
+void placement_format_cpulist(const cpu_set_t *set, char *buf, size_t len)
+{
+    size_t used = 0;
+    int cpu = 0, last;
+
+    buf[0] = '\0';
+    while(cpu < CPU_SETSIZE)
+    {
+        if(!CPU_ISSET(cpu, set)) { cpu++; continue; }
+        for(last = cpu; (last + 1 < CPU_SETSIZE) && CPU_ISSET(last + 1, set); last++);
+        used += snprintf(buf + used, (used < len) ? len - used : 0, (last > cpu) ? "%s%d-%d" : "%s%d",
+                         (used > 0) ? "," : "", cpu, last);
+        cpu = last + 1;
+    }
+    if(used == 0) snprintf(buf, len, "none");
+}
+
+static void read_sys_cpulist(const char *file, cpu_set_t *set)
+{
+    char path[128], line[256];
+    FILE *fp;
+
+    CPU_ZERO(set);
+    snprintf(path, sizeof(path), SYS_CPU_DIR "%s", file);
+    fp = fopen(path, "r");
+    if(!fp) return;
+    if(fgets(line, sizeof(line), fp)) parse_cpulist(line, set);
+    fclose(fp);
+}
+
+static int first_cpu(const cpu_set_t *set)
+{
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        if(CPU_ISSET(cpu, set)) return cpu;
+    return -1;
+}
+
+static int last_cpu(const cpu_set_t *set)
+{
+    for(int cpu = CPU_SETSIZE - 1; cpu >= 0; cpu--)
+        if(CPU_ISSET(cpu, set)) return cpu;
+    return -1;
+}
+
+void placement_defaults(void)
+{
+    int rt_max_prio = sched_get_priority_max(SCHED_FIFO);
+    cpu_set_t control, vision;
+    int control_cpu;
+
+    read_sys_cpulist("online", &online_cpus);
+    read_sys_cpulist("isolated", &isolated_cpus);
+    read_sys_cpulist("nohz_full", &nohz_cpus);
+    if(CPU_COUNT(&online_cpus) == 0) CPU_SET(0, &online_cpus);
+
+    // Core 0 takes most of the interrupts, so without isolcpus the control core is the last one
+    control_cpu = (CPU_COUNT(&isolated_cpus) > 0) ? first_cpu(&isolated_cpus) : last_cpu(&online_cpus);
+    CPU_ZERO(&control);
+    CPU_SET(control_cpu, &control);
+
+    // Vision balances over the remaining non isolated cores, the scheduler does not balance onto isolated ones
+    CPU_XOR(&vision, &online_cpus, &isolated_cpus);
+    CPU_AND(&vision, &vision, &online_cpus);
+    CPU_CLR(control_cpu, &vision);
+    if(CPU_COUNT(&vision) == 0) vision = control;
+
+    for(int i = 0; i < NUM_PLACEMENTS; i++) placement[i].name = placement_names[i];
+
+    placement[PLACE_SEQUENCER].cpus = control;
+    placement[PLACE_SEQUENCER].priority = rt_max_prio;
+    placement[PLACE_INPUT].cpus = control;
+    placement[PLACE_INPUT].priority = rt_max_prio - 1;
+    placement[PLACE_MOTOR].cpus = control;
+    placement[PLACE_MOTOR].priority = rt_max_prio - 2;
+    placement[PLACE_ULTRASONIC].cpus = control;
+    placement[PLACE_ULTRASONIC].priority = rt_max_prio - 3;
+    placement[PLACE_CAMERA].cpus = vision;
+    placement[PLACE_CAMERA].priority = rt_max_prio - 1;
+    placement[PLACE_HOUSEKEEPING].cpus = vision;
+    placement[PLACE_HOUSEKEEPING].priority = 0;
+}
+
+static int placement_set(const char *name, const char *cpulist, int priority)
+{
+    for(int i = 0; i < NUM_PLACEMENTS; i++)
+    {
+        if(strcmp(name, placement_names[i]) != 0) continue;
+        if(parse_cpulist(cpulist, &placement[i].cpus) < 0)
+        {
+            printf("Bad cpu list '%s' for %s\r\n", cpulist, name);
+            return -1;
+        }
+        if(priority >= 0) placement[i].priority = priority;
+        return 0;
+    }
+
+    printf("Unknown thread '%s' in placement\r\n", name);
+    return -1;
+}
+
+int placement_parse(const char *spec)
+{
+    char name[32], cpulist[128];
+    int priority = -1;
+
+    // thread=cpulist[:priority]
+    if(sscanf(spec, "%31[^=]=%127[^:]:%d", name, cpulist, &priority) < 2)
+    {
+        printf("Bad placement '%s', expected thread=cpulist[:priority]\r\n", spec);
+        return -1;
+    }
+    return placement_set(name, cpulist, priority);
+}
+
+int placement_load_file(const char *path)
+{
+    char line[256], name[32], cpulist[128];
+    int priority, lineno = 0, rc = 0;
+    FILE *fp = fopen(path, "r");
+
+    if(!fp)
+    {
+        perror("placement file");
+        return -1;
+    }
+
+    while(fgets(line, sizeof(line), fp))
+    {
+        char *comment = strchr(line, '#');
+
+        lineno++;
+        if(comment) *comment = '\0';
+        if(sscanf(line, "%31s", name) != 1) continue;
+
+        if((sscanf(line, "%31s %127s %d", name, cpulist, &priority) != 3) || (placement_set(name, cpulist, priority) < 0))
+        {
+            printf("%s:%d: expected <thread> <cpulist> <priority>\r\n", path, lineno);
+            rc = -1;
+        }
+    }
+
+    fclose(fp);
+    return rc;
+}
+
+int placement_validate(void)
+{
+    int rt_max_prio = sched_get_priority_max(SCHED_FIFO);
+    cpu_set_t offline, shared;
+    char list[128];
+    int rc = 0;
+
+    placement_format_cpulist(&online_cpus, list, sizeof(list));
+    printf("Online cores %s", list);
+    placement_format_cpulist(&isolated_cpus, list, sizeof(list));
+    printf(", isolated %s", list);
+    placement_format_cpulist(&nohz_cpus, list, sizeof(list));
+    printf(", nohz_full %s\r\n", list);
+
+    for(int i = 0; i < NUM_PLACEMENTS; i++)
+    {
+        thread_placement_t *p = &placement[i];
+        cpu_set_t isolated_part;
+
+        CPU_AND(&offline, &p->cpus, &online_cpus);
+        CPU_XOR(&offline, &offline, &p->cpus);
+        if((CPU_COUNT(&p->cpus) == 0) || (CPU_COUNT(&offline) > 0))
+        {
+            placement_format_cpulist(&p->cpus, list, sizeof(list));
+            printf("Placement error: %s on cores %s, not all online\r\n", p->name, list);
+            rc = -1;
+        }
+        if((p->priority < 0) || (p->priority > rt_max_prio))
+        {
+            printf("Placement error: %s priority %d outside 0..%d\r\n", p->name, p->priority, rt_max_prio);
+            rc = -1;
+        }
+
+        CPU_AND(&isolated_part, &p->cpus, &isolated_cpus);
+        if((CPU_COUNT(&p->cpus) > 1) && (CPU_COUNT(&isolated_part) > 0))
+            printf("Placement warning: %s spans isolated cores, it will not be balanced across them\r\n", p->name);
+    }
+
+    // Collision avoidance must not wait behind frame processing, unavoidable on a single core
+    CPU_ZERO(&shared);
+    for(int i = PLACE_SEQUENCER; (i < NUM_PLACEMENTS) && (CPU_COUNT(&online_cpus) > 1); i++)
+    {
+        if((i == PLACE_CAMERA) || (i == PLACE_HOUSEKEEPING)) continue;
+        CPU_AND(&shared, &placement[i].cpus, &placement[PLACE_CAMERA].cpus);
+        if(CPU_COUNT(&shared) > 0)
+            printf("Placement warning: %s shares a core with camera\r\n", placement[i].name);
+    }
+
+    return rc;
+}
+
+void placement_set_attr(placement_id_t id, pthread_attr_t *attr)
+{
+    struct sched_param param;
+
+    param.sched_priority = placement[id].priority;
+    pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(attr, (param.sched_priority > 0) ? SCHED_FIFO : SCHED_OTHER);
+    pthread_attr_setschedparam(attr, &param);
+    pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &placement[id].cpus);
+}
+
+void placement_print_thread(FILE *out, const char *name, pthread_t thread)
+{
+    struct sched_param param;
+    cpu_set_t cpus, flags;
+    char list[128];
+    int policy;
+
+    if((pthread_getschedparam(thread, &policy, &param) != 0) ||
+       (pthread_getaffinity_np(thread, sizeof(cpus), &cpus) != 0))
+    {
+        fprintf(out, "%-12s unknown\n", name);
+        return;
+    }
+
+    placement_format_cpulist(&cpus, list, sizeof(list));
+    fprintf(out, "%-12s %-11s prio %2d  cores %-8s", name,
+            (policy == SCHED_FIFO) ? "SCHED_FIFO" : (policy == SCHED_RR) ? "SCHED_RR" :
+            (policy == SCHED_DEADLINE) ? "SCHED_DL" : "SCHED_OTHER",
+            param.sched_priority, list);
+    CPU_AND(&flags, &cpus, &isolated_cpus);
+    if(CPU_COUNT(&flags) > 0) fprintf(out, " isolated");
+    CPU_AND(&flags, &cpus, &nohz_cpus);
+    if(CPU_COUNT(&flags) > 0) fprintf(out, " nohz_full");
+    fprintf(out, "\n");
+}
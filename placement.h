@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    placement.h
+ * @brief   This file contains declaration of the CPU affinity and priority placement of the RT threads
+ * @date    18th October 2026
+ *
+ * By default the sequencer, the control services and the input thread share one
+ * control core: the first isolcpus core when there is one, otherwise the last
+ * core. Vision gets every other core. A config file or -a specs can override
+ * any entry.
+ *
+ * Config file, one thread per line, '#' starts a comment:
+ *     <thread> <cpulist> <priority>      e.g.  camera 0-2 98
+ * Priority is the SCHED_FIFO priority, 0 runs the thread as SCHED_OTHER.
+ */
+
+#ifndef _PLACEMENT_H
+#define _PLACEMENT_H
+
+#include <stdio.h>
+#include <sched.h>
+#include <pthread.h>
+
+typedef enum
+{
+    PLACE_SEQUENCER = 0,
+    PLACE_CAMERA,
+    PLACE_MOTOR,
+    PLACE_ULTRASONIC,
+    PLACE_INPUT,
+    PLACE_HOUSEKEEPING,     // main, trace drainer, anything not RT
+    NUM_PLACEMENTS
+} placement_id_t;
+
+typedef struct
+{
+    const char *name;
+    cpu_set_t cpus;
+    int priority;
+} thread_placement_t;
+
+extern thread_placement_t placement[NUM_PLACEMENTS];
+
+/*
+ * @brief Function to fill the default placement from the online and isolated cores
+ */
+void placement_defaults(void);
+
+/*
+ * @brief Function to apply one "thread=cpulist[:priority]" override, returns -1 on a bad spec
+ */
+int placement_parse(const char *spec);
+
+/*
+ * @brief Function to apply the overrides of a config file, returns -1 when it cannot be read or has a bad line
+ */
+int placement_load_file(const char *path);
+
+/*
+ * @brief Function to check every entry against the online cores and the priority range, warnings only for isolcpus misuse
+ */
+int placement_validate(void);
+
+/*
+ * @brief Function to set the policy, priority and affinity of a placement on thread attributes
+ */
+void placement_set_attr(placement_id_t id, pthread_attr_t *attr);
+
+/*
+ * @brief Function to format a cpu set as a kernel style cpulist such as "0-2,4"
+ */
+void placement_format_cpulist(const cpu_set_t *set, char *buf, size_t len);
+
+/*
+ * @brief Function to print the policy, priority and affinity a running thread actually got
+ */
+void placement_print_thread(FILE *out, const char *name, pthread_t thread);
+
+#endif
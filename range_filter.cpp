@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    range_filter.cpp
+ * @brief   This file contains definition of the forward range estimator and stop decision
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "range_filter.h"
+#include "rt_time.h"
+
+#define RANGE_FILTER_MIN_MEDIAN (3)   // pings needed before the median gate applies
+
+// Median of the pings in the ring, each moved to at_ns with the estimated rate so a moving obstacle is not an outlier
+static double ring_median(const range_filter_t *f, uint64_t at_ns)
+{
+    double sorted[RANGE_FILTER_WINDOW], moved;
+    double rate = f->tracking ? f->rate_mm_s : 0.0;
+
+    // Insertion sort, the window is tiny
+    for(int i = 0; i < f->ring_count; i++)
+    {
+        int j = i;
+
+        moved = f->ring_mm[i] + rate * ((double)(int64_t)(at_ns - f->ring_ns[i]) / NSEC_PER_SEC);
+        for(; (j > 0) && (sorted[j - 1] > moved); j--) sorted[j] = sorted[j - 1];
+        sorted[j] = moved;
+    }
+    return sorted[f->ring_count / 2];
+}
+
+static void filter_start(range_filter_t *f, int32_t distance_mm, uint64_t measured_ns)
+{
+    f->tracking = true;
+    f->range_mm = distance_mm;
+    f->rate_mm_s = 0.0;
+    f->p[0][0] = RANGE_FILTER_NOISE_MM * RANGE_FILTER_NOISE_MM;
+    f->p[0][1] = f->p[1][0] = 0.0;
+    f->p[1][1] = RANGE_FILTER_RATE_MM_S * RANGE_FILTER_RATE_MM_S;
+    f->last_ns = measured_ns;
+}
+
+void range_filter_init(range_filter_t *f, uint64_t interval_ns)
+{
+    f->interval_ns = interval_ns;
+    f->rejected = 0;
+    f->last_ns = 0;
+    range_filter_reset(f);
+}
+
+void range_filter_reset(range_filter_t *f)
+{
+    f->ring_count = 0;
+    f->ring_head = 0;
+    f->tracking = false;
+}
+
+bool range_filter_update(range_filter_t *f, int32_t distance_mm, uint64_t measured_ns)
+{
+    int32_t previous_mm = f->ring_mm[(f->ring_head + RANGE_FILTER_WINDOW - 1) % RANGE_FILTER_WINDOW];
+    bool accepted = true;
+    double dt, q, p00, p01, p11, s, k0, k1, innovation;
+
+    if(f->ring_count >= RANGE_FILTER_MIN_MEDIAN)
+    {
+        // A spurious echo agrees with neither the recent pings nor the one before it
+        accepted = (fabs(distance_mm - ring_median(f, measured_ns)) <= RANGE_FILTER_GATE_MM) ||
+                   (abs(distance_mm - previous_mm) <= RANGE_FILTER_GATE_MM);
+    }
+
+    f->ring_mm[f->ring_head] = distance_mm;
+    f->ring_ns[f->ring_head] = measured_ns;
+    f->ring_head = (f->ring_head + 1) % RANGE_FILTER_WINDOW;
+    if(f->ring_count < RANGE_FILTER_WINDOW) f->ring_count++;
+
+    if(!accepted)
+    {
+        f->rejected++;
+        return false;
+    }
+
+    if(!f->tracking || (measured_ns <= f->last_ns))
+    {
+        filter_start(f, distance_mm, measured_ns);
+        return true;
+    }
+
+    // Predict with the constant velocity model, white acceleration noise
+    dt = (double)(measured_ns - f->last_ns) / NSEC_PER_SEC;
+    q = RANGE_FILTER_ACCEL_MM_S2 * RANGE_FILTER_ACCEL_MM_S2;
+    f->range_mm += f->rate_mm_s * dt;
+    p00 = f->p[0][0] + dt * (f->p[0][1] + f->p[1][0]) + dt * dt * f->p[1][1] + q * dt * dt * dt * dt / 4.0;
+    p01 = f->p[0][1] + dt * f->p[1][1] + q * dt * dt * dt / 2.0;
+    p11 = f->p[1][1] + q * dt * dt;
+    f->last_ns = measured_ns;
+
+    innovation = distance_mm - f->range_mm;
+    if((innovation > RANGE_FILTER_RESET_MM) || (innovation < -RANGE_FILTER_RESET_MM))
+    {
+        // Something else is in front now, start over instead of averaging it in
+        filter_start(f, distance_mm, measured_ns);
+        return true;
+    }
+
+    // Update, only the range is measured
+    s = p00 + RANGE_FILTER_NOISE_MM * RANGE_FILTER_NOISE_MM;
+    k0 = p00 / s;
+    k1 = p01 / s;
+    f->range_mm += k0 * innovation;
+    f->rate_mm_s += k1 * innovation;
+    f->p[0][0] = (1.0 - k0) * p00;
+    f->p[0][1] = f->p[1][0] = (1.0 - k0) * p01;
+    f->p[1][1] = p11 - k1 * p01;
+    return true;
+}
+
+void range_filter_decide(const range_filter_t *f, uint64_t now_ns, int32_t margin_mm, int32_t drive_mm_s,
+                         double brake_tau_s, range_decision_t *out)
+{
+    double range_mm, closing_mm_s, horizon_s, ahead_s;
+
+    if(!f->tracking)
+    {
+        out->range_mm = -1;
+        out->closing_mm_s = 0;
+        out->ttc_ms = -1;
+        out->stop = false;
+        return;
+    }
+
+    ahead_s = (now_ns > f->last_ns) ? (double)(now_ns - f->last_ns) / NSEC_PER_SEC : 0.0;
+    range_mm = f->range_mm + f->rate_mm_s * ahead_s;
+    closing_mm_s = (-f->rate_mm_s > drive_mm_s) ? -f->rate_mm_s : drive_mm_s;
+
+    // The next chance to stop is one ping later, then the stop itself takes the latency
+    // and the motors cover about closing speed x time constant while they brake
+    horizon_s = (double)(f->interval_ns + RANGE_FILTER_STOP_LATENCY_NS) / NSEC_PER_SEC + brake_tau_s;
+
+    out->range_mm = (int32_t)range_mm;
+    out->closing_mm_s = (int32_t)closing_mm_s;
+    out->ttc_ms = (closing_mm_s <= 0.0) ? -1 : (range_mm <= margin_mm) ? 0 : (int32_t)((range_mm - margin_mm) * 1000.0 / closing_mm_s);
+    out->stop = (range_mm - margin_mm) <= closing_mm_s * horizon_s;
+}
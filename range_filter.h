@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    range_filter.h
+ * @brief   This file contains declaration of the forward range estimator and stop decision
+ * @date    18th October 2026
+ *
+ * Each ping first goes through outlier rejection. The last few pings are moved to
+ * the time of the new one with the estimated range rate. A ping further than the
+ * gate from both their median and the ping before it is treated as a spurious
+ * echo and dropped. A real obstacle that appears suddenly therefore costs
+ * one extra ping. Accepted pings update a constant velocity Kalman filter of range
+ * and range rate. A jump bigger than the reset distance restarts the filter, so a
+ * new obstacle is not averaged in.
+ *
+ * The stop decision predicts the range to the decision time. It then checks whether
+ * the vehicle could still stop before the margin if it waited for the next ping.
+ * The closing speed used is the larger of the measured one and the speed of the
+ * forward command, so a stopped vehicle only drives on when the forward command
+ * would be safe. All state is preallocated, and one update takes a few hundred ns.
+ */
+
+#ifndef _RANGE_FILTER_H
+#define _RANGE_FILTER_H
+
+#include <stdint.h>
+
+#define RANGE_FILTER_WINDOW (5)                 // pings the median is taken over
+#define RANGE_FILTER_GATE_MM (100)              // further than this from the median and the last ping is an outlier
+#define RANGE_FILTER_RESET_MM (300)             // innovation that restarts the filter on a new obstacle
+#define RANGE_FILTER_NOISE_MM (10.0)            // ping standard deviation
+#define RANGE_FILTER_ACCEL_MM_S2 (2000.0)       // standard deviation of the unmodelled closing acceleration
+#define RANGE_FILTER_RATE_MM_S (1000.0)         // standard deviation of the rate when the filter starts
+#define RANGE_FILTER_STOP_LATENCY_NS (10000000ULL)  // echo flight of the next ping plus echo end to PWM zero
+
+typedef struct
+{
+    int32_t ring_mm[RANGE_FILTER_WINDOW];   // last raw pings, accepted or not
+    uint64_t ring_ns[RANGE_FILTER_WINDOW];  // and when they were measured
+    int ring_count;
+    int ring_head;
+    bool tracking;           // at least one ping accepted since the last reset
+    double range_mm;         // state at last_ns
+    double rate_mm_s;        // negative while closing in
+    double p[2][2];          // state covariance
+    uint64_t last_ns;        // measured time of the last accepted ping
+    uint64_t interval_ns;    // time until the next ping is due
+    uint32_t rejected;       // outliers dropped since init
+} range_filter_t;
+
+typedef struct
+{
+    int32_t range_mm;        // predicted to the decision time, -1 when not tracking
+    int32_t closing_mm_s;    // closing speed the decision was made with
+    int32_t ttc_ms;          // time to reach the margin at that speed, -1 when not closing
+    bool stop;
+} range_decision_t;
+
+/*
+ * @brief Function to start with an empty filter, interval_ns is the ping period of the ultrasonic service
+ */
+void range_filter_init(range_filter_t *f, uint64_t interval_ns);
+
+/*
+ * @brief Function to forget the tracked obstacle and the ping history, on an out of range ping or a gear change
+ */
+void range_filter_reset(range_filter_t *f);
+
+/*
+ * @brief Function to add one ping measured at measured_ns, returns false when it was rejected as an outlier
+ */
+bool range_filter_update(range_filter_t *f, int32_t distance_mm, uint64_t measured_ns);
+
+/*
+ * @brief Function to decide at now_ns whether to stop before margin_mm, drive_mm_s is the speed of the forward command
+ */
+void range_filter_decide(const range_filter_t *f, uint64_t now_ns, int32_t margin_mm, int32_t drive_mm_s,
+                         double brake_tau_s, range_decision_t *out);
+
+#endif
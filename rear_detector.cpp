@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    rear_detector.cpp
+ * @brief   This file contains definition of the camera based rear obstacle detector
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "rear_detector.h"
+#include "motor.h"
+#include "service_stats.h"
+#include "blackboard.h"
+
+using namespace cv;
+
+#define DOWNSCALE (4)
+#define EDGE_THRESHOLD (40)            // |dx| + |dy| of a gray level edge
+#define DETECT_DENSITY (0.12f)         // near band edge density that counts as an obstacle
+#define CLEAR_DENSITY (0.08f)          // hysteresis, density must fall below this to clear
+#define DETECT_FRAMES (2)              // consecutive frames needed to raise the flag
+#define CLEAR_FRAMES (3)               // consecutive frames needed to clear it
+
+void rear_detector_init(rear_detector_t *det, Size frame_size)
+{
+    // Bottom 40% of the frame between the near ends of the guide lines
+    int x0 = frame_size.width * 20 / 100, x1 = frame_size.width * 80 / 100;
+    int y0 = frame_size.height * 60 / 100;
+    int small_w = ((x1 - x0) / DOWNSCALE) & ~15;     // whole SIMD vectors per row
+
+    det->roi = Rect(x0, y0, small_w * DOWNSCALE, frame_size.height - y0);
+    det->gray.create(det->roi.size(), CV_8UC1);
+    det->small.create(Size(small_w, det->roi.height / DOWNSCALE), CV_8UC1);
+    det->prev.create(det->small.size(), CV_8UC1);
+    rear_detector_reset(det);
+}
+
+void rear_detector_reset(rear_detector_t *det)
+{
+    det->have_prev = false;
+    det->above_count = 0;
+    det->below_count = 0;
+    det->obstacle = false;
+    det->motion = 0.0f;
+    for(int i = 0; i < REAR_DETECTOR_BANDS; i++)
+        det->edge_density[i] = 0.0f;
+}
+
+uint32_t rear_detector_edge_count(const Mat &gray, int y0, int y1, uint8_t threshold)
+{
+    const int w = gray.cols;
+    uint32_t count = 0;
+
+    if(y1 > gray.rows - 1) y1 = gray.rows - 1;    // needs the row below
+
+    for(int y = y0; y < y1; y++)
+    {
+        const uchar *row = gray.ptr<uchar>(y);
+        const uchar *next = gray.ptr<uchar>(y + 1);
+        int x = 0;
+
+#if CV_SIMD128
+        const v_uint8x16 vthresh = v_setall_u8(threshold);
+        const v_uint8x16 one = v_setall_u8(1);
+        v_uint16x8 acc = v_setall_u16(0);
+
+        for(; x <= w - 17; x += 16)
+        {
+            v_uint8x16 p = v_load(row + x);
+            v_uint8x16 g = v_absdiff(p, v_load(row + x + 1)) + v_absdiff(p, v_load(next + x));   // saturating
+            v_uint16x8 lo, hi;
+
+            v_expand((g > vthresh) & one, lo, hi);
+            acc = acc + lo + hi;
+        }
+
+        v_uint32x4 a0, a1;
+        v_expand(acc, a0, a1);
+        count += v_reduce_sum(a0 + a1);
+#endif
+
+        for(; x < w - 1; x++)
+        {
+            int g = abs(row[x] - row[x + 1]) + abs(row[x] - next[x]);
+            count += (g > threshold);
+        }
+    }
+
+    return count;
+}
+
+uint64_t rear_detector_abs_diff(const Mat &a, const Mat &b)
+{
+    const int w = a.cols;
+    uint64_t sum = 0;
+
+    for(int y = 0; y < a.rows; y++)
+    {
+        const uchar *pa = a.ptr<uchar>(y);
+        const uchar *pb = b.ptr<uchar>(y);
+        int x = 0;
+
+#if CV_SIMD128
+        v_uint32x4 acc = v_setall_u32(0);
+
+        for(; x <= w - 16; x += 16)
+        {
+            v_uint16x8 lo, hi;
+            v_uint32x4 l0, l1, h0, h1;
+
+            v_expand(v_absdiff(v_load(pa + x), v_load(pb + x)), lo, hi);
+            v_expand(lo, l0, l1);
+            v_expand(hi, h0, h1);
+            acc = acc + l0 + l1 + h0 + h1;
+        }
+        sum += v_reduce_sum(acc);
+#endif
+
+        for(; x < w; x++)
+            sum += abs(pa[x] - pb[x]);
+    }
+
+    return sum;
+}
+
+bool rear_detector_process(rear_detector_t *det, const Mat &frame)
+{
+    const int band_rows = det->small.rows / REAR_DETECTOR_BANDS;
+    float near_density;
+
+    // Both calls write into the preallocated buffers, the sizes never change
+    cvtColor(frame(det->roi), det->gray, COLOR_BGR2GRAY);
+    resize(det->gray, det->small, det->small.size(), 0, 0, INTER_AREA);
+
+    for(int i = 0; i < REAR_DETECTOR_BANDS; i++)
+    {
+        uint32_t edges = rear_detector_edge_count(det->small, i * band_rows, (i + 1) * band_rows, EDGE_THRESHOLD);
+        det->edge_density[i] = (float)edges / (float)(band_rows * det->small.cols);
+    }
+
+    if(det->have_prev)
+        det->motion = (float)rear_detector_abs_diff(det->small, det->prev) / (float)det->small.total();
+    det->small.copyTo(det->prev);
+    det->have_prev = true;
+
+    near_density = det->edge_density[REAR_DETECTOR_BANDS - 1];
+    if(near_density > DETECT_DENSITY)
+    {
+        det->above_count++;
+        det->below_count = 0;
+        if(det->above_count >= DETECT_FRAMES) det->obstacle = true;
+    }
+    else if(near_density < CLEAR_DENSITY)
+    {
+        det->below_count++;
+        det->above_count = 0;
+        if(det->below_count >= CLEAR_FRAMES) det->obstacle = false;
+    }
+
+    return det->obstacle;
+}
+
+void rear_detector_stage(pipeline_frame_t *frame, void *arg)
+{
+    rear_detector_t *det = (rear_detector_t *)arg;
+    bool was_obstacle = det->obstacle;
+
+    if(blackboard_gear() != GEAR_REVERSE) return;
+
+    // Published on every frame so readers can tell how old the decision is
+    blackboard_set_rear(rear_detector_process(det, frame->image), frame->capture_ns);
+    if(det->obstacle && !was_obstacle) motor_emergency_stop(EVENT_REAR_OBSTACLE_STOP, frame->capture_ns);
+}
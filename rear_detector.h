@@ -0,0 +1,79 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    rear_detector.h
+ * @brief   This file contains declaration of the camera based rear obstacle detector
+ * @date    18th October 2026
+ *
+ * The ground band behind the car (between the guide lines) is converted to gray,
+ * downscaled 4x into preallocated buffers and split into far/mid/near bands.
+ * An empty floor has few edges, so an obstacle shows up as edge density in the
+ * near band. Frame differencing against the previous frame is computed as a
+ * motion score for diagnostics. Both kernels use 128 bit universal intrinsics.
+ */
+
+#ifndef _REAR_DETECTOR_H
+#define _REAR_DETECTOR_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <opencv2/core/core.hpp>
+
+#include "frame_pipeline.h"
+
+#define REAR_DETECTOR_BANDS (3)   // far, mid, near
+
+typedef struct
+{
+    cv::Rect roi;            // ground band in frame coordinates
+    cv::Mat gray;            // full resolution gray copy of the roi
+    cv::Mat small;           // downscaled gray, the detector works on this
+    cv::Mat prev;            // previous downscaled frame for differencing
+    bool have_prev;
+    int above_count;         // consecutive frames above the detect threshold
+    int below_count;         // consecutive frames below the clear threshold
+    bool obstacle;
+    float edge_density[REAR_DETECTOR_BANDS];
+    float motion;            // mean absolute difference to the previous frame
+} rear_detector_t;
+
+/*
+ * @brief Function to size the roi and preallocate every buffer for the given frame size
+ */
+void rear_detector_init(rear_detector_t *det, cv::Size frame_size);
+
+/*
+ * @brief Function to forget the frame history and the decision, on every entry to reverse
+ */
+void rear_detector_reset(rear_detector_t *det);
+
+/*
+ * @brief Function to run the detector on one BGR frame, returns true while an obstacle is seen
+ */
+bool rear_detector_process(rear_detector_t *det, const cv::Mat &frame);
+
+/*
+ * @brief Kernel counting pixels in rows [y0, y1) whose horizontal plus vertical gradient exceeds threshold
+ */
+uint32_t rear_detector_edge_count(const cv::Mat &gray, int y0, int y1, uint8_t threshold);
+
+/*
+ * @brief Kernel summing the absolute difference of two equally sized gray images
+ */
+uint64_t rear_detector_abs_diff(const cv::Mat &a, const cv::Mat &b);
+
+/*
+ * @brief Frame pipeline stage feeding the obstacle flag while reversing, arg is the rear_detector_t
+ */
+void rear_detector_stage(pipeline_frame_t *frame, void *arg);
+
+#endif
@@ -0,0 +1,319 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    record.cpp
+ * @brief   This file contains definition of the input recorder and the replay source
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <atomic>
+
+#include "record.h"
+#include "service_stats.h"
+
+#define RECORD_ALIGN(n) (((n) + 7) & ~(uint64_t)7)
+
+static_assert(sizeof(record_header_t) == 16, "record headers are written to file as is");
+static_assert(sizeof(record_file_header_t) % 8 == 0, "the first record must be 8 byte aligned");
+
+static uint8_t *record_base = NULL;
+static uint64_t record_size = 0;
+static int record_fd = -1;
+static std::atomic<uint64_t> record_offset(0);
+static std::atomic<uint64_t> record_count(0);
+static std::atomic<uint64_t> record_dropped(0);
+
+static record_reader_t replay;
+static bool replay_is_open = false;
+static bool replay_is_fast = false;
+static uint64_t replay_local_epoch_ns = 0;     // 0 until the sequencer starts
+static std::atomic<uint64_t> replay_elapsed_ns(0);
+
+/*
+ * mlockall(MCL_FUTURE) would fault in and lock a whole new file mapping. An
+ * inaccessible mapping is not populated, so it is unlocked first and only then
+ * opened up. Written pages stay ordinary page cache the kernel can write back.
+ */
+static void *map_unlocked(int fd, size_t length, int prot)
+{
+    void *base = mmap(NULL, length, PROT_NONE, MAP_SHARED, fd, 0);
+
+    if(base == MAP_FAILED) return NULL;
+    munlock(base, length);
+    if(mprotect(base, length, prot) != 0)
+    {
+        munmap(base, length);
+        return NULL;
+    }
+    return base;
+}
+
+int record_open(const char *path, uint64_t max_bytes)
+{
+    record_file_header_t *header;
+
+    record_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(record_fd < 0)
+    {
+        perror(path);
+        return -1;
+    }
+
+    if(ftruncate(record_fd, max_bytes) != 0)
+    {
+        perror("Recording ftruncate");
+        close(record_fd);
+        return -1;
+    }
+
+    record_base = (uint8_t *)map_unlocked(record_fd, max_bytes, PROT_READ | PROT_WRITE);
+    if(!record_base)
+    {
+        perror("Recording mmap");
+        close(record_fd);
+        return -1;
+    }
+
+    record_size = max_bytes;
+    header = (record_file_header_t *)record_base;
+    memcpy(header->magic, RECORD_FILE_MAGIC, sizeof(header->magic));
+    header->version = RECORD_FILE_VERSION;
+    header->header_size = sizeof(record_header_t);
+    header->used_bytes = 0;
+    header->dropped = 0;
+
+    record_offset.store(sizeof(record_file_header_t), std::memory_order_relaxed);
+    record_count.store(0, std::memory_order_relaxed);
+    record_dropped.store(0, std::memory_order_relaxed);
+    printf("Recording inputs to %s, up to %llu MB\r\n", path, (unsigned long long)(max_bytes >> 20));
+    return 0;
+}
+
+bool record_enabled(void)
+{
+    return record_base != NULL;
+}
+
+bool record_append(record_stream_t stream, uint16_t flags, uint64_t timestamp_ns,
+                   const void *head, uint32_t head_len, const void *data, uint32_t data_len)
+{
+    uint64_t length = sizeof(record_header_t) + head_len + data_len;
+    uint64_t offset, next;
+    record_header_t *record;
+
+    if(!record_base) return false;
+
+    // A full file drops what does not fit, a smaller record may still go in
+    offset = record_offset.load(std::memory_order_relaxed);
+    do
+    {
+        next = offset + RECORD_ALIGN(length);
+        if(next > record_size)
+        {
+            record_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while(!record_offset.compare_exchange_weak(offset, next, std::memory_order_relaxed));
+
+    record = (record_header_t *)(record_base + offset);
+    record->stream = stream;
+    record->flags = flags;
+    record->timestamp_ns = timestamp_ns;
+    if(head_len) memcpy(record + 1, head, head_len);
+    if(data_len) memcpy((uint8_t *)(record + 1) + head_len, data, data_len);
+
+    // The length commits the record
+    __atomic_store_n(&record->length, (uint32_t)length, __ATOMIC_RELEASE);
+    record_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void record_close(FILE *out)
+{
+    record_file_header_t *header = (record_file_header_t *)record_base;
+    uint64_t used = record_offset.load(std::memory_order_relaxed);
+    uint64_t dropped = record_dropped.load(std::memory_order_relaxed);
+
+    if(!record_base) return;
+
+    header->used_bytes = used;
+    header->dropped = dropped;
+    munmap(record_base, record_size);
+    record_base = NULL;
+
+    if(ftruncate(record_fd, used) != 0) perror("Recording ftruncate");
+    close(record_fd);
+    record_fd = -1;
+
+    fprintf(out, "Recording: %llu records, %.1f MB, %llu dropped\n", (unsigned long long)record_count.load(std::memory_order_relaxed),
+            used / (1024.0 * 1024.0), (unsigned long long)dropped);
+}
+
+int record_reader_open(record_reader_t *reader, const char *path)
+{
+    const record_file_header_t *header;
+    const record_header_t *record;
+    struct stat st;
+    uint64_t offset, end;
+
+    reader->fd = open(path, O_RDONLY);
+    if(reader->fd < 0)
+    {
+        perror(path);
+        return -1;
+    }
+
+    if((fstat(reader->fd, &st) != 0) || ((size_t)st.st_size < sizeof(record_file_header_t)))
+    {
+        printf("%s is not a recording\r\n", path);
+        close(reader->fd);
+        return -1;
+    }
+
+    reader->size = st.st_size;
+    reader->base = (const uint8_t *)map_unlocked(reader->fd, reader->size, PROT_READ);
+    if(!reader->base)
+    {
+        perror("Recording mmap");
+        close(reader->fd);
+        return -1;
+    }
+
+    header = (const record_file_header_t *)reader->base;
+    if((memcmp(header->magic, RECORD_FILE_MAGIC, sizeof(header->magic)) != 0) || (header->version != RECORD_FILE_VERSION))
+    {
+        printf("%s is not a version %d recording\r\n", path, RECORD_FILE_VERSION);
+        record_reader_close(reader);
+        return -1;
+    }
+
+    // A recorder that never closed leaves the file at full size, the walk stops at the first unfinished record
+    end = ((header->used_bytes != 0) && (header->used_bytes < reader->size)) ? header->used_bytes : reader->size;
+    reader->epoch_ns = 0;
+    reader->last_ns = 0;
+    for(int s = 0; s < RECORD_NUM_STREAMS; s++) reader->index[s].clear();
+
+    for(offset = sizeof(record_file_header_t); offset + sizeof(record_header_t) <= end; offset += RECORD_ALIGN(record->length))
+    {
+        record = (const record_header_t *)(reader->base + offset);
+        if((record->length < sizeof(record_header_t)) || (offset + record->length > end)) break;
+        if(record->stream >= RECORD_NUM_STREAMS) continue;
+
+        reader->index[record->stream].push_back(offset);
+        if(record->timestamp_ns > reader->last_ns) reader->last_ns = record->timestamp_ns;
+    }
+
+    if(!reader->index[RECORD_STREAM_EPOCH].empty())
+        reader->epoch_ns = record_reader_entry(reader, RECORD_STREAM_EPOCH, 0)->timestamp_ns;
+    else
+    {
+        // No sequencer start recorded, the timeline starts at the first record
+        for(int s = 0; s < RECORD_NUM_STREAMS; s++)
+        {
+            if(reader->index[s].empty()) continue;
+            uint64_t first = record_reader_entry(reader, (record_stream_t)s, 0)->timestamp_ns;
+            if((reader->epoch_ns == 0) || (first < reader->epoch_ns)) reader->epoch_ns = first;
+        }
+    }
+
+    return 0;
+}
+
+size_t record_reader_count(const record_reader_t *reader, record_stream_t stream)
+{
+    return reader->index[stream].size();
+}
+
+const record_header_t *record_reader_entry(const record_reader_t *reader, record_stream_t stream, size_t i)
+{
+    return (const record_header_t *)(reader->base + reader->index[stream][i]);
+}
+
+void record_reader_close(record_reader_t *reader)
+{
+    if(reader->base) munmap((void *)reader->base, reader->size);
+    if(reader->fd >= 0) close(reader->fd);
+    reader->base = NULL;
+    reader->fd = -1;
+}
+
+int replay_open(const char *path, bool fast)
+{
+    if(record_reader_open(&replay, path) < 0) return -1;
+
+    replay_is_open = true;
+    replay_is_fast = fast;
+    printf("Replaying %s %s: %zu echo records, %zu button events, %zu frames over %.1f s\r\n", path, fast ? "as fast as possible" : "in real time",
+           record_reader_count(&replay, RECORD_STREAM_ECHO), record_reader_count(&replay, RECORD_STREAM_BUTTON),
+           record_reader_count(&replay, RECORD_STREAM_FRAME), (replay.last_ns - replay.epoch_ns) / 1e9);
+    return 0;
+}
+
+bool replay_active(void)
+{
+    return replay_is_open;
+}
+
+bool replay_fast(void)
+{
+    return replay_is_fast;
+}
+
+const record_reader_t *replay_reader(void)
+{
+    return &replay;
+}
+
+void replay_start(uint64_t local_epoch_ns)
+{
+    replay_local_epoch_ns = local_epoch_ns;
+    replay_elapsed_ns.store(0, std::memory_order_relaxed);
+}
+
+void replay_set_elapsed(uint64_t elapsed_ns)
+{
+    replay_elapsed_ns.store(elapsed_ns, std::memory_order_relaxed);
+}
+
+uint64_t replay_now(void)
+{
+    if(replay_is_fast || (replay_local_epoch_ns == 0))
+        return replay.epoch_ns + replay_elapsed_ns.load(std::memory_order_relaxed);
+
+    return replay.epoch_ns + (rt_now() - replay_local_epoch_ns);
+}
+
+uint64_t replay_to_local(uint64_t recorded_ns)
+{
+    if(replay_is_fast) return rt_now();
+
+    return recorded_ns - replay.epoch_ns + replay_local_epoch_ns;
+}
+
+bool replay_done(void)
+{
+    return replay_is_open && (replay_now() > replay.last_ns + RECORD_REPLAY_TAIL_NS);
+}
+
+void replay_close(void)
+{
+    if(!replay_is_open) return;
+
+    record_reader_close(&replay);
+    replay_is_open = false;
+}
@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    record.h
+ * @brief   This file contains declaration of the input recorder and the replay source
+ * @date    18th October 2026
+ *
+ * A recording is one append-only file, mapped once at startup. Any thread
+ * appends a record by reserving its space with a compare and swap on the write
+ * offset. The record is committed by storing its length last, so a reader
+ * stops at the first record that was never finished. Each record is a 16 byte
+ * header and its payload, padded to 8 bytes:
+ *  - echo: one record per trigger and per edge the ultrasonic service saw, tagged with the sensor
+ *  - button: every debounced press and release
+ *  - frame: the raw YUYV or MJPEG buffer of the driver, or the BGR image of the OpenCV backend
+ *  - motor: every change of the motor command, to compare a replay against
+ *
+ * In replay the file is mapped read-only and indexed per stream. Records are
+ * released on the recorded timeline, which starts at the epoch record the
+ * sequencer start writes. Replay runs in real time, or as fast as possible with
+ * the sequencer advancing the timeline one cycle at a time.
+ */
+
+#ifndef _RECORD_H
+#define _RECORD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#define RECORD_FILE_MAGIC "PPREC001"
+#define RECORD_FILE_VERSION (1)
+#define RECORD_DEFAULT_SIZE_MB (1024)        // sparse, only what is written takes disk space
+#define RECORD_REPLAY_TAIL_NS (1000000000ULL)  // replay stops one second after the last record
+
+typedef enum
+{
+    RECORD_STREAM_EPOCH = 0,   // sequencer start, no payload
+    RECORD_STREAM_ECHO,        // flags RECORD_ECHO_* and the sensor index, no payload
+    RECORD_STREAM_BUTTON,      // record_button_t
+    RECORD_STREAM_FRAME,       // record_frame_t followed by the image data
+    RECORD_STREAM_MOTOR,       // record_motor_t
+    RECORD_NUM_STREAMS
+} record_stream_t;
+
+#define RECORD_ECHO_TRIGGER (0)
+#define RECORD_ECHO_RISING (1)
+#define RECORD_ECHO_FALLING (2)
+#define RECORD_ECHO_KIND_MASK (0xff)
+#define RECORD_ECHO_SENSOR_SHIFT (8)   // sensor 0 is the front sensor, the only one of older recordings
+
+#define RECORD_ECHO_FLAGS(kind, sensor) ((uint16_t)((kind) | ((sensor) << RECORD_ECHO_SENSOR_SHIFT)))
+#define RECORD_ECHO_KIND(flags) ((flags) & RECORD_ECHO_KIND_MASK)
+#define RECORD_ECHO_SENSOR(flags) ((flags) >> RECORD_ECHO_SENSOR_SHIFT)
+
+typedef struct
+{
+    uint16_t stream;
+    uint16_t flags;
+    uint32_t length;          // header and payload, 0 while the record is written
+    uint64_t timestamp_ns;    // CLOCK_MONOTONIC
+} record_header_t;
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t used_bytes;      // written at close, 0 when the recorder never closed
+    uint64_t dropped;
+} record_file_header_t;
+
+typedef struct
+{
+    int32_t input;            // id of input_add_line
+    int32_t pressed;
+} record_button_t;
+
+typedef struct
+{
+    uint32_t pixfmt;          // V4L2 fourcc, V4L2_PIX_FMT_BGR24 for the OpenCV backend
+    uint16_t width;
+    uint16_t height;
+    uint32_t stride;          // bytes per line, 0 for MJPEG
+    uint32_t size;            // bytes of image data after this header
+} record_frame_t;
+
+typedef struct
+{
+    int32_t speed[2];
+    int32_t direction[2];
+    uint64_t cycle;           // sequencer cycle the command was applied in
+} record_motor_t;
+
+typedef struct
+{
+    const uint8_t *base;
+    size_t size;
+    int fd;
+    uint64_t epoch_ns;        // recorded sequencer start
+    uint64_t last_ns;         // newest record
+    std::vector<uint64_t> index[RECORD_NUM_STREAMS];   // record offsets per stream, in file order
+} record_reader_t;
+
+/*
+ * @brief Function to create a recording of at most max_bytes, call after rt_memory_init so the file is not locked
+ */
+int record_open(const char *path, uint64_t max_bytes);
+
+/*
+ * @brief Function to check whether a recording is open
+ */
+bool record_enabled(void);
+
+/*
+ * @brief Function to append a record with a payload in two parts from any thread, returns false when not recording or full
+ */
+bool record_append(record_stream_t stream, uint16_t flags, uint64_t timestamp_ns,
+                   const void *head, uint32_t head_len, const void *data, uint32_t data_len);
+
+/*
+ * @brief Function to finish the recording, truncates the file to what was written
+ */
+void record_close(FILE *out);
+
+/*
+ * @brief Function to map and index a recording
+ */
+int record_reader_open(record_reader_t *reader, const char *path);
+
+/*
+ * @brief Function to get the number of records of a stream
+ */
+size_t record_reader_count(const record_reader_t *reader, record_stream_t stream);
+
+/*
+ * @brief Function to get the i-th record of a stream, its payload follows the header
+ */
+const record_header_t *record_reader_entry(const record_reader_t *reader, record_stream_t stream, size_t i);
+
+/*
+ * @brief Function to unmap a recording
+ */
+void record_reader_close(record_reader_t *reader);
+
+static inline const void *record_payload(const record_header_t *header)
+{
+    return header + 1;
+}
+
+/*
+ * @brief Function to replay a recording instead of the hardware inputs, fast runs the timeline as fast as possible
+ */
+int replay_open(const char *path, bool fast);
+
+/*
+ * @brief Function to check whether inputs come from a replay
+ */
+bool replay_active(void);
+
+/*
+ * @brief Function to check whether the replay runs as fast as possible
+ */
+bool replay_fast(void);
+
+/*
+ * @brief Function to get the recording being replayed
+ */
+const record_reader_t *replay_reader(void);
+
+/*
+ * @brief Function to align the recorded sequencer start with the local one
+ */
+void replay_start(uint64_t local_epoch_ns);
+
+/*
+ * @brief Function to move the timeline of a fast replay, elapsed since the sequencer start
+ */
+void replay_set_elapsed(uint64_t elapsed_ns);
+
+/*
+ * @brief Function to get the current time on the recorded timeline
+ */
+uint64_t replay_now(void);
+
+/*
+ * @brief Function to map a recorded time to the local clock, a fast replay maps everything to now
+ */
+uint64_t replay_to_local(uint64_t recorded_ns);
+
+/*
+ * @brief Function to check whether the timeline has passed the last record
+ */
+bool replay_done(void);
+
+/*
+ * @brief Function to unmap the replayed recording
+ */
+void replay_close(void);
+
+#endif
@@ -0,0 +1,115 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    record_inspect.cpp
+ * @brief   This file contains the summary and the regression check of recordings written by main -R
+ * @date    18th October 2026
+ *
+ * Usage: record_inspect <recording> [replayed recording]
+ * Prints what each stream of a recording holds. Given the recording of a replay
+ * of it (main -P recording -R replayed), compares the motor command changes of
+ * both runs in order and reports the first divergence and how many sequencer
+ * cycles the matching changes moved. Exits with 1 on a divergence.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "record.h"
+
+static const char *stream_names[RECORD_NUM_STREAMS] = { "epoch", "echo", "button", "frame", "motor" };
+
+static void summary(const char *path, const record_reader_t *rec)
+{
+    size_t pings = 0, frame_bytes = 0;
+
+    printf("%s: %.1f s\n", path, (rec->last_ns - rec->epoch_ns) / 1e9);
+    for(int s = 0; s < RECORD_NUM_STREAMS; s++)
+        printf("  %-8s %zu records\n", stream_names[s], record_reader_count(rec, (record_stream_t)s));
+
+    for(size_t i = 0; i < record_reader_count(rec, RECORD_STREAM_ECHO); i++)
+        if(RECORD_ECHO_KIND(record_reader_entry(rec, RECORD_STREAM_ECHO, i)->flags) == RECORD_ECHO_TRIGGER) pings++;
+    for(size_t i = 0; i < record_reader_count(rec, RECORD_STREAM_FRAME); i++)
+        frame_bytes += ((const record_frame_t *)record_payload(record_reader_entry(rec, RECORD_STREAM_FRAME, i)))->size;
+
+    printf("  %zu pings, %.1f MB of frames\n", pings, frame_bytes / (1024.0 * 1024.0));
+}
+
+static const record_motor_t *motor_change(const record_reader_t *rec, size_t i)
+{
+    return (const record_motor_t *)record_payload(record_reader_entry(rec, RECORD_STREAM_MOTOR, i));
+}
+
+static void print_change(const char *label, const record_motor_t *m)
+{
+    printf("  %s: cycle %llu speed %d/%d direction %d/%d\n", label, (unsigned long long)m->cycle,
+           m->speed[0], m->speed[1], m->direction[0], m->direction[1]);
+}
+
+static int compare(const record_reader_t *recorded, const record_reader_t *replayed)
+{
+    size_t n_rec = record_reader_count(recorded, RECORD_STREAM_MOTOR);
+    size_t n_rep = record_reader_count(replayed, RECORD_STREAM_MOTOR);
+    size_t n = (n_rec < n_rep) ? n_rec : n_rep;
+    long long shift, max_shift = 0;
+
+    for(size_t i = 0; i < n; i++)
+    {
+        const record_motor_t *a = motor_change(recorded, i), *b = motor_change(replayed, i);
+
+        if(memcmp(a->speed, b->speed, sizeof(a->speed)) || memcmp(a->direction, b->direction, sizeof(a->direction)))
+        {
+            printf("Motor commands diverge at change %zu\n", i);
+            print_change("recorded", a);
+            print_change("replayed", b);
+            return 1;
+        }
+
+        shift = (long long)b->cycle - (long long)a->cycle;
+        if(llabs(shift) > llabs(max_shift)) max_shift = shift;
+    }
+
+    if(n_rec != n_rep)
+    {
+        printf("Motor commands diverge after change %zu: %zu recorded, %zu replayed\n", n, n_rec, n_rep);
+        return 1;
+    }
+
+    printf("Motor commands match: %zu changes, largest shift %lld sequencer cycles\n", n, max_shift);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    record_reader_t recorded, replayed;
+    int rc = 0;
+
+    if((argc < 2) || (argc > 3))
+    {
+        printf("Usage: %s <recording> [replayed recording]\n", argv[0]);
+        exit(-1);
+    }
+
+    if(record_reader_open(&recorded, argv[1]) < 0) exit(-1);
+    summary(argv[1], &recorded);
+
+    if(argc == 3)
+    {
+        if(record_reader_open(&replayed, argv[2]) < 0) exit(-1);
+        summary(argv[2], &replayed);
+        rc = compare(&recorded, &replayed);
+        record_reader_close(&replayed);
+    }
+
+    record_reader_close(&recorded);
+    return rc;
+}
@@ -0,0 +1,240 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    rm_analysis.cpp
+ * @brief   This file contains definition of the fixed priority schedulability analysis of the services
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "rm_analysis.h"
+#include "placement.h"
+#include "trace.h"
+#include "rt_time.h"
+
+#define RM_MAX_TASKS (16)
+
+static uint64_t period_ns(unsigned int divisor, unsigned int seq_hz)
+{
+    return ((uint64_t)divisor * NSEC_PER_SEC) / seq_hz;
+}
+
+static bool interferes(const rm_task_t *hp, const rm_task_t *task)
+{
+    cpu_set_t shared;
+
+    // SCHED_FIFO runs an equal priority task that was released first to completion, count it too
+    CPU_AND(&shared, &hp->cpus, &task->cpus);
+    return (hp->priority > 0) && (hp->priority >= task->priority) && (CPU_COUNT(&shared) > 0);
+}
+
+// R = C + S + sum over higher priority tasks of ceil((R + Sj) / Tj) * Cj, iterated to the fixed point
+static uint64_t response_time(const rm_task_t *tasks, const unsigned int *divisors, int num_tasks, int i, unsigned int seq_hz)
+{
+    uint64_t deadline = period_ns(divisors[i], seq_hz);
+    uint64_t r = tasks[i].exec_ns + tasks[i].suspend_ns, next;
+
+    for(;;)
+    {
+        next = tasks[i].exec_ns + tasks[i].suspend_ns;
+        for(int j = 0; j < num_tasks; j++)
+        {
+            if((j == i) || !interferes(&tasks[j], &tasks[i])) continue;
+            uint64_t tj = period_ns(divisors[j], seq_hz);
+            next += ((r + tasks[j].suspend_ns + tj - 1) / tj) * tasks[j].exec_ns;
+        }
+        if(next > deadline) return RM_MISS;
+        if(next == r) return r;
+        r = next;
+    }
+}
+
+static bool all_schedulable(const rm_task_t *tasks, const unsigned int *divisors, int num_tasks, unsigned int seq_hz)
+{
+    for(int i = 0; i < num_tasks; i++)
+        if((tasks[i].priority > 0) && (response_time(tasks, divisors, num_tasks, i, seq_hz) == RM_MISS)) return false;
+    return true;
+}
+
+bool rm_analysis_run(const rm_task_t *tasks, int num_tasks, unsigned int seq_hz, rm_result_t *results)
+{
+    unsigned int divisors[RM_MAX_TASKS];
+    bool feasible = true;
+
+    if(num_tasks > RM_MAX_TASKS) return false;
+
+    for(int i = 0; i < num_tasks; i++) divisors[i] = tasks[i].divisor;
+
+    for(int i = 0; i < num_tasks; i++)
+    {
+        rm_result_t *res = &results[i];
+
+        memset(res, 0, sizeof(*res));
+        if(tasks[i].priority <= 0) continue;
+
+        res->response_ns = response_time(tasks, divisors, num_tasks, i, seq_hz);
+        if(res->response_ns == RM_MISS) feasible = false;
+        else res->slack_ns = period_ns(divisors[i], seq_hz) - res->response_ns;
+
+        // Fastest sequencer sub-rate this task can run at with everything else unchanged
+        for(unsigned int d = 1; d <= seq_hz; d++)
+        {
+            divisors[i] = d;
+            if(all_schedulable(tasks, divisors, num_tasks, seq_hz))
+            {
+                res->min_divisor = d;
+                break;
+            }
+        }
+        divisors[i] = tasks[i].divisor;
+    }
+
+    return feasible;
+}
+
+bool rm_analysis_report(FILE *out, const rm_task_t *tasks, int num_tasks, unsigned int seq_hz)
+{
+    rm_result_t results[RM_MAX_TASKS];
+    bool feasible, rm_order = true;
+    char cores[64];
+
+    if(num_tasks > RM_MAX_TASKS) return false;
+    feasible = rm_analysis_run(tasks, num_tasks, seq_hz, results);
+
+    fprintf(out, "---- schedulability, %u Hz sequencer ----\n", seq_hz);
+    fprintf(out, "%-12s %10s %4s %-6s %10s %10s %6s %10s %10s %10s\n",
+            "service", "period_ms", "prio", "cores", "cpu_us", "susp_us", "U", "resp_us", "slack_us", "max_hz");
+    for(int i = 0; i < num_tasks; i++)
+    {
+        const rm_task_t *t = &tasks[i];
+        uint64_t period = period_ns(t->divisor, seq_hz);
+
+        placement_format_cpulist(&t->cpus, cores, sizeof(cores));
+        fprintf(out, "%-12s %10.2f %4d %-6s %10.1f %10.1f %6.3f ", t->name, period / 1e6, t->priority, cores,
+                t->exec_ns / 1e3, t->suspend_ns / 1e3, (double)t->exec_ns / period);
+        if(t->priority <= 0)
+            fprintf(out, "%10s %10s %10s\n", "-", "-", "-");
+        else if(results[i].response_ns == RM_MISS)
+            fprintf(out, "%10s %10s ", "MISS", "-");
+        else
+            fprintf(out, "%10.1f %10.1f ", results[i].response_ns / 1e3, results[i].slack_ns / 1e3);
+        if(t->priority > 0)
+        {
+            if(results[i].min_divisor) fprintf(out, "%10.2f\n", (double)seq_hz / results[i].min_divisor);
+            else fprintf(out, "%10s\n", "none");
+        }
+
+        // Rate monotonic means a shorter period never has a lower priority on a shared core
+        for(int j = 0; j < num_tasks; j++)
+            if((tasks[j].priority > 0) && interferes(t, &tasks[j]) && (t->priority > tasks[j].priority) && (t->divisor > tasks[j].divisor))
+                rm_order = false;
+    }
+
+    // Utilization per core, a task spread over several cores counts evenly on each
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        double u = 0.0;
+        int n = 0;
+
+        for(int i = 0; i < num_tasks; i++)
+        {
+            if((tasks[i].priority <= 0) || !CPU_ISSET(cpu, &tasks[i].cpus)) continue;
+            u += (double)tasks[i].exec_ns / period_ns(tasks[i].divisor, seq_hz) / CPU_COUNT(&tasks[i].cpus);
+            n++;
+        }
+        if(n == 0) continue;
+
+        double bound = n * (pow(2.0, 1.0 / n) - 1.0);
+        fprintf(out, "core %d: %d tasks, U %.3f, Liu & Layland bound %.3f, %s\n", cpu, n, u, bound,
+                (u <= bound) ? "feasible by the bound" : (u <= 1.0) ? "above the bound, see response times" : "overloaded");
+    }
+
+    fprintf(out, "priorities are %srate monotonic\n", rm_order ? "" : "NOT ");
+    fprintf(out, "service set is %s\n", feasible ? "schedulable" : "NOT schedulable");
+    return feasible;
+}
+
+uint64_t rm_exec_budget(const latency_histogram_t *hist, double percentile)
+{
+    if(percentile <= 0.0) return hist->max_ns.load(std::memory_order_relaxed);
+    return latency_histogram_percentile(hist, percentile);
+}
+
+void rm_task_budget(rm_task_t *task, const latency_histogram_t *exec, const latency_histogram_t *cpu, double percentile)
+{
+    uint64_t wall_ns = rm_exec_budget(exec, percentile);
+
+    // Both at the same percentile, the task alone still takes its measured wall clock time
+    task->exec_ns = rm_exec_budget(cpu, percentile);
+    task->suspend_ns = (wall_ns > task->exec_ns) ? wall_ns - task->exec_ns : 0;
+}
+
+int rm_load_trace(const char *path, latency_histogram_t *exec, latency_histogram_t *cpu, rm_task_t *tasks,
+                  bool *have_config, unsigned int *seq_hz)
+{
+    trace_file_header_t header;
+    trace_record_t rec;
+    FILE *in = fopen(path, "rb");
+
+    if(!in)
+    {
+        perror("trace file");
+        return -1;
+    }
+
+    if((fread(&header, sizeof(header), 1, in) != 1) ||
+       (memcmp(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic)) != 0) ||
+       (header.version != TRACE_FILE_VERSION) ||
+       (header.record_size != sizeof(trace_record_t)))
+    {
+        printf("%s is not a version %d trace file\n", path, TRACE_FILE_VERSION);
+        fclose(in);
+        return -1;
+    }
+
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        latency_histogram_init(&exec[i]);
+        latency_histogram_init(&cpu[i]);
+        have_config[i] = false;
+    }
+
+    while(fread(&rec, sizeof(rec), 1, in) == 1)
+    {
+        if(rec.service_id >= NUM_SERVICES) continue;
+
+        if((rec.event == TRACE_EV_SERVICE) && (rec.stop_ns >= rec.start_ns))
+        {
+            latency_histogram_record(&exec[rec.service_id], rec.stop_ns - rec.start_ns);
+            latency_histogram_record(&cpu[rec.service_id], (uint64_t)rec.arg);
+        }
+        else if(rec.event == TRACE_EV_RELEASE_CONFIG)
+        {
+            rm_task_t *t = &tasks[rec.service_id];
+
+            t->name = service_name(rec.service_id);
+            t->divisor = rec.seq;
+            t->priority = rec.arg;
+            CPU_ZERO(&t->cpus);
+            for(int cpu = 0; cpu < 64; cpu++)
+                if(rec.start_ns & (1ULL << cpu)) CPU_SET(cpu, &t->cpus);
+            *seq_hz = (unsigned int)rec.stop_ns;
+            have_config[rec.service_id] = true;
+        }
+    }
+
+    fclose(in);
+    return 0;
+}
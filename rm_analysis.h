@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    rm_analysis.h
+ * @brief   This file contains declaration of the fixed priority schedulability analysis of the services
+ * @date    18th October 2026
+ *
+ * Tasks are the sequencer released services: period = divisor / sequencer rate,
+ * deadline = period, priority and cores from the placement, execution time from
+ * a trace of a previous run. Each task's response time is found by exact
+ * response time analysis. A task is interfered with by every higher or equal
+ * priority task that shares a core with it. For a task spanning several cores
+ * this is pessimistic.
+ *
+ * The execution time is the CPU time of a release. The rest of its wall clock
+ * time, the ultrasonic service sleeping on its echoes, is self-suspension: it
+ * adds to the task's own response time, and it is release jitter of the task
+ * for the ones it interferes with, since its CPU work can come late and bunch up.
+ */
+
+#ifndef _RM_ANALYSIS_H
+#define _RM_ANALYSIS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sched.h>
+
+#include "latency_histogram.h"
+#include "service_stats.h"
+
+#define RM_MISS (UINT64_MAX)
+
+typedef struct
+{
+    const char *name;
+    unsigned int divisor;       // released every divisor-th sequencer cycle
+    int priority;               // SCHED_FIFO priority, 0 is not real time and is left out
+    cpu_set_t cpus;
+    uint64_t exec_ns;           // CPU time budget the analysis assumes
+    uint64_t suspend_ns;        // time a release sleeps, the rest of its wall clock time
+} rm_task_t;
+
+typedef struct
+{
+    uint64_t response_ns;       // worst case response time, RM_MISS when it exceeds the deadline
+    uint64_t slack_ns;          // deadline - response time
+    unsigned int min_divisor;   // smallest divisor that keeps every task schedulable, 0 when none does
+} rm_result_t;
+
+/*
+ * @brief Function to run response time analysis on all tasks, returns true when every RT task meets its deadline
+ */
+bool rm_analysis_run(const rm_task_t *tasks, int num_tasks, unsigned int seq_hz, rm_result_t *results);
+
+/*
+ * @brief Function to print utilization and the Liu & Layland bound per core, response time, slack and max safe rate per task
+ */
+bool rm_analysis_report(FILE *out, const rm_task_t *tasks, int num_tasks, unsigned int seq_hz);
+
+/*
+ * @brief Function to get the execution time budget from a histogram, the maximum when percentile <= 0
+ */
+uint64_t rm_exec_budget(const latency_histogram_t *hist, double percentile);
+
+/*
+ * @brief Function to set the CPU time budget and the self-suspension of a task from its traced histograms
+ */
+void rm_task_budget(rm_task_t *task, const latency_histogram_t *exec, const latency_histogram_t *cpu, double percentile);
+
+/*
+ * @brief Function to read the per service execution times and release config from a binary trace file
+ *
+ * exec and cpu must hold NUM_SERVICES histograms, start to stop and CPU time of each
+ * release. tasks gets the recorded release config, have_config tells which
+ * services had one and seq_hz receives the sequencer rate.
+ */
+int rm_load_trace(const char *path, latency_histogram_t *exec, latency_histogram_t *cpu, rm_task_t *tasks,
+                  bool *have_config, unsigned int *seq_hz);
+
+#endif
@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    rm_analyze.cpp
+ * @brief   This file contains the offline schedulability analysis of a trace file written by main -t
+ * @date    18th October 2026
+ *
+ * Usage: rm_analyze [-p percentile] [-m margin_pct] [-d service=divisor]... <trace file>
+ * -p   execution time budget percentile, 0 (default) takes the observed maximum
+ * -m   extra margin added to every CPU time budget, in percent
+ * -d   what-if: analyze a service at another sequencer divisor
+ * Exits with 1 when the service set is not schedulable.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rm_analysis.h"
+#include "trace.h"
+
+static int apply_divisor(rm_task_t *tasks, const char *spec)
+{
+    const char *eq = strchr(spec, '=');
+    char *end;
+    long divisor;
+
+    if(!eq) return -1;
+    divisor = strtol(eq + 1, &end, 10);
+    if((*end != '\0') || (divisor < 1)) return -1;
+
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        if((strlen(service_name(i)) == (size_t)(eq - spec)) && (strncmp(service_name(i), spec, eq - spec) == 0))
+        {
+            tasks[i].divisor = divisor;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    static latency_histogram_t exec[NUM_SERVICES];
+    static latency_histogram_t cpu[NUM_SERVICES];
+    rm_task_t tasks[NUM_SERVICES];
+    bool have_config[NUM_SERVICES];
+    const char *divisor_specs[NUM_SERVICES];
+    int num_specs = 0;
+    unsigned int seq_hz = 0;
+    double percentile = 0.0, margin = 0.0;
+    int opt;
+
+    memset(tasks, 0, sizeof(tasks));
+
+    while((opt = getopt(argc, argv, "p:m:d:")) != -1)
+    {
+        switch(opt)
+        {
+            case 'p':
+                percentile = atof(optarg);
+                break;
+            case 'm':
+                margin = atof(optarg);
+                break;
+            case 'd':
+                if(num_specs < NUM_SERVICES) divisor_specs[num_specs++] = optarg;
+                break;
+            default:
+                printf("Usage: %s [-p percentile] [-m margin_pct] [-d service=divisor] <trace file>\n", argv[0]);
+                exit(-1);
+        }
+    }
+
+    if(optind != argc - 1)
+    {
+        printf("Usage: %s [-p percentile] [-m margin_pct] [-d service=divisor] <trace file>\n", argv[0]);
+        exit(-1);
+    }
+
+    if(rm_load_trace(argv[optind], exec, cpu, tasks, have_config, &seq_hz) != 0) exit(-1);
+
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        if(!have_config[i] || (seq_hz == 0))
+        {
+            printf("%s has no release_config record, the trace predates the analyzer\n", service_name(i));
+            exit(-1);
+        }
+        rm_task_budget(&tasks[i], &exec[i], &cpu[i], percentile);
+        tasks[i].exec_ns *= 1.0 + margin / 100.0;
+    }
+
+    for(int i = 0; i < num_specs; i++)
+    {
+        if(apply_divisor(tasks, divisor_specs[i]) != 0)
+        {
+            printf("Bad divisor override %s, expected <service>=<divisor>\n", divisor_specs[i]);
+            exit(-1);
+        }
+    }
+
+    if(percentile > 0.0) printf("budget: p%g CPU time + %g%%, self-suspension at p%g\n", percentile, margin, percentile);
+    else printf("budget: max CPU time + %g%%, max self-suspension\n", margin);
+
+    return rm_analysis_report(stdout, tasks, NUM_SERVICES, seq_hz) ? 0 : 1;
+}
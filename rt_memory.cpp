@@ -0,0 +1,179 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    rt_memory.cpp
+ * @brief   This file contains definition of the memory locking and steady state allocation guard
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <atomic>
+
+#include "rt_memory.h"
+
+#define RT_STACK_PREFAULT_BYTES (RT_STACK_SIZE * 3 / 4)   // leave room for the frames above the toucher
+
+extern "C"
+{
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t num, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+}
+
+static std::atomic<uint64_t> guarded_allocs[RT_MEMORY_MAX_GUARDS];
+static bool strict_mode = false;
+static thread_local int guard_id = -1;    // local exec TLS, reading it never allocates
+static long last_minflt = 0, last_majflt = 0;
+
+static const char strict_msg[] = "rt_memory: allocation in a guarded RT thread, aborting\n";
+
+// Called on every allocation of the process, may only touch atomics and the TLS id
+static inline void rt_memory_count(void)
+{
+    if(guard_id < 0) return;
+
+    guarded_allocs[guard_id].fetch_add(1, std::memory_order_relaxed);
+    if(strict_mode)
+    {
+        if(write(STDERR_FILENO, strict_msg, sizeof(strict_msg) - 1) < 0) { }
+        abort();
+    }
+}
+
+extern "C"
+{
+void *malloc(size_t size)
+{
+    rt_memory_count();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t num, size_t size)
+{
+    rt_memory_count();
+    return __libc_calloc(num, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    rt_memory_count();
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    rt_memory_count();
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    rt_memory_count();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **out, size_t alignment, size_t size)
+{
+    void *ptr;
+
+    if((alignment % sizeof(void *)) || (alignment & (alignment - 1))) return EINVAL;
+    rt_memory_count();
+    ptr = __libc_memalign(alignment, size);
+    if(!ptr) return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+}
+
+bool rt_memory_strict(void)
+{
+    return strict_mode;
+}
+
+int rt_memory_init(bool strict)
+{
+    char *heap;
+    long page = sysconf(_SC_PAGESIZE);
+
+    strict_mode = strict;
+    for(int i = 0; i < RT_MEMORY_MAX_GUARDS; i++)
+        guarded_allocs[i].store(0, std::memory_order_relaxed);
+
+    rt_memory_report(stdout, "before locking");
+
+    // Every allocation from the main heap, which is never given back, all threads share it
+    mallopt(M_MMAP_MAX, 0);
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_ARENA_MAX, 1);
+
+    if(mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+        perror("mlockall");
+        return -1;
+    }
+
+    // Grow the heap and fault it in once, the free keeps it in the arena
+    heap = (char *)malloc(RT_HEAP_PREFAULT_BYTES);
+    if(!heap)
+    {
+        printf("Failed to prefault %d bytes of heap\r\n", RT_HEAP_PREFAULT_BYTES);
+        return -1;
+    }
+    for(long i = 0; i < RT_HEAP_PREFAULT_BYTES; i += page) heap[i] = 0;
+    free(heap);
+
+    rt_memory_report(stdout, "locking and heap prefault");
+    return 0;
+}
+
+void rt_memory_stack_attr(pthread_attr_t *attr)
+{
+    pthread_attr_setstacksize(attr, RT_STACK_SIZE);
+}
+
+void __attribute__((noinline)) rt_memory_prefault_stack(void)
+{
+    volatile char stack[RT_STACK_PREFAULT_BYTES];
+    long page = sysconf(_SC_PAGESIZE);
+
+    for(long i = 0; i < RT_STACK_PREFAULT_BYTES; i += page) stack[i] = 0;
+    (void)stack[0];
+}
+
+void rt_memory_guard(int id)
+{
+    guard_id = ((id >= 0) && (id < RT_MEMORY_MAX_GUARDS)) ? id : -1;
+}
+
+uint64_t rt_memory_guarded_allocs(int id)
+{
+    return ((id >= 0) && (id < RT_MEMORY_MAX_GUARDS)) ? guarded_allocs[id].load(std::memory_order_relaxed) : 0;
+}
+
+void rt_memory_report(FILE *out, const char *phase)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(out, "page faults %s: %ld minor, %ld major\n", phase,
+            usage.ru_minflt - last_minflt, usage.ru_majflt - last_majflt);
+    last_minflt = usage.ru_minflt;
+    last_majflt = usage.ru_majflt;
+    fflush(out);
+}
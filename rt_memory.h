@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    rt_memory.h
+ * @brief   This file contains declaration of the memory locking and steady state allocation guard
+ * @date    18th October 2026
+ *
+ * At startup all memory is locked (mlockall MCL_CURRENT | MCL_FUTURE). glibc is
+ * told to keep freed memory and never use mmap, so every later allocation comes
+ * from a heap that is already resident. The heap is prefaulted with a large
+ * allocation. RT threads get small, fully locked stacks.
+ *
+ * This file also overrides malloc, calloc, realloc and the aligned allocators of
+ * the whole process. That includes OpenCV. Each override forwards to glibc. When
+ * the calling thread is guarded, the allocation is counted against the thread's
+ * guard id, and in strict mode the process aborts.
+ */
+
+#ifndef _RT_MEMORY_H
+#define _RT_MEMORY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define RT_MEMORY_MAX_GUARDS (8)
+#define RT_STACK_SIZE (1024 * 1024)                 // per RT thread, locked in full
+#define RT_HEAP_PREFAULT_BYTES (16 * 1024 * 1024)   // frames, OpenCV temporaries and the trace rings fit
+#define RT_MEMORY_WARMUP_RELEASES (16)              // releases of a service before it is guarded
+
+/*
+ * @brief Function to lock and prefault the process memory, strict aborts on a guarded allocation
+ */
+int rt_memory_init(bool strict);
+
+/*
+ * @brief Function to check whether a guarded allocation aborts the process
+ */
+bool rt_memory_strict(void);
+
+/*
+ * @brief Function to set the stack size of an RT thread on its attributes
+ */
+void rt_memory_stack_attr(pthread_attr_t *attr);
+
+/*
+ * @brief Function to touch the stack of the calling thread down to its working depth
+ */
+void rt_memory_prefault_stack(void);
+
+/*
+ * @brief Function to count every allocation of the calling thread against id from now on, -1 stops counting
+ */
+void rt_memory_guard(int id);
+
+/*
+ * @brief Function to get the number of allocations counted against a guard id
+ */
+uint64_t rt_memory_guarded_allocs(int id);
+
+/*
+ * @brief Function to print the page faults since the previous report
+ */
+void rt_memory_report(FILE *out, const char *phase);
+
+#endif
@@ -0,0 +1,131 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    rt_time.h
+ * @brief   This file contains the header only integer nanosecond time of all the services
+ * @date    18th October 2026
+ *
+ * Times are int64_t nanoseconds (rt_ns_t). Plain integer arithmetic and comparisons apply,
+ * and the conversions are constexpr. There are two clock domains, and they must not be mixed:
+ *  - rt_now(): CLOCK_MONOTONIC, the timeline. The sequencer releases, clock_nanosleep,
+ *    sem_clockwait and the kernel timestamps of gpiod edges and V4L2 buffers are all on
+ *    it, so any time that is compared with another or slept until comes from here.
+ *  - rt_stopwatch(): only for durations, start and stop read on it. CLOCK_MONOTONIC_RAW,
+ *    which NTP does not slew, or with RT_TIME_COUNTER defined on aarch64 the ARM generic
+ *    timer counter read straight from user space, without a vDSO call.
+ * Neither one ever goes backwards. rt_thread_cpu() is the CPU time of the calling
+ * thread, it stands still while the thread sleeps.
+ */
+
+#ifndef _RT_TIME_H
+#define _RT_TIME_H
+
+#include <stdint.h>
+#include <time.h>
+
+#define MSEC_PER_SEC (1000)
+#define NSEC_PER_SEC (1000000000)
+#define NSEC_PER_MSEC (1000000)
+#define NSEC_PER_MICROSEC (1000)
+
+typedef int64_t rt_ns_t;
+
+/*
+ * @brief Function to convert a timespec to nanoseconds
+ */
+static inline constexpr rt_ns_t timespec_to_ns(const struct timespec *ts)
+{
+    return (rt_ns_t)ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+/*
+ * @brief Function to convert nanoseconds to a timespec
+ */
+static inline constexpr void ns_to_timespec(rt_ns_t ns, struct timespec *ts)
+{
+    ts->tv_sec = ns / NSEC_PER_SEC;
+    ts->tv_nsec = ns % NSEC_PER_SEC;
+}
+
+static inline rt_ns_t rt_clock_read(clockid_t clock)
+{
+    struct timespec now;
+
+    clock_gettime(clock, &now);
+    return timespec_to_ns(&now);
+}
+
+/*
+ * @brief Function to get the CLOCK_MONOTONIC time, the timeline every release, sleep and kernel timestamp is on
+ */
+static inline rt_ns_t rt_now(void)
+{
+    return rt_clock_read(CLOCK_MONOTONIC);
+}
+
+/*
+ * @brief Function to get the CLOCK_MONOTONIC_RAW time, only for durations
+ */
+static inline rt_ns_t rt_now_raw(void)
+{
+    return rt_clock_read(CLOCK_MONOTONIC_RAW);
+}
+
+/*
+ * @brief Function to get the CPU time the calling thread has used, only for durations of that thread
+ */
+static inline rt_ns_t rt_thread_cpu(void)
+{
+    return rt_clock_read(CLOCK_THREAD_CPUTIME_ID);
+}
+
+#if defined(RT_TIME_COUNTER) && defined(__aarch64__)
+inline uint64_t rt_counter_frequency(void)
+{
+    uint64_t freq;
+
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    return freq;
+}
+
+// Counter ticks to nanoseconds as a 32.32 fixed point factor, 54 MHz on a Pi 4
+inline const uint64_t rt_counter_mult = ((uint64_t)NSEC_PER_SEC << 32) / rt_counter_frequency();
+
+/*
+ * @brief Function to get the ARM generic timer virtual count in nanoseconds, only for durations
+ */
+static inline rt_ns_t rt_now_counter(void)
+{
+    uint64_t count;
+
+    // The barrier keeps the read from being speculated ahead of the code before it
+    asm volatile("isb; mrs %0, cntvct_el0" : "=r"(count) : : "memory");
+    return (rt_ns_t)(((unsigned __int128)count * rt_counter_mult) >> 32);
+}
+
+/*
+ * @brief Function to get the time of the duration clock, the generic timer counter in this build
+ */
+static inline rt_ns_t rt_stopwatch(void)
+{
+    return rt_now_counter();
+}
+#else
+/*
+ * @brief Function to get the time of the duration clock, CLOCK_MONOTONIC_RAW in this build
+ */
+static inline rt_ns_t rt_stopwatch(void)
+{
+    return rt_now_raw();
+}
+#endif
+
+#endif
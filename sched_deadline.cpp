@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    sched_deadline.cpp
+ * @brief   This file contains definition of the SCHED_DEADLINE wrappers
+ * @date    18th October 2026
+ *
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "sched_deadline.h"
+
+// Layout of struct sched_attr, SCHED_ATTR_SIZE_VER0
+typedef struct
+{
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+} sched_deadline_attr_t;
+
+int sched_deadline_set(uint64_t runtime_ns, uint64_t deadline_ns, uint64_t period_ns)
+{
+    sched_deadline_attr_t attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.sched_policy = SCHED_DEADLINE;
+    attr.sched_runtime = runtime_ns;
+    attr.sched_deadline = deadline_ns;
+    attr.sched_period = period_ns;
+
+    // pid 0 is the calling thread
+    return (int)syscall(SYS_sched_setattr, 0, &attr, 0);
+}
+
+int sched_deadline_get(uint64_t *runtime_ns, uint64_t *deadline_ns, uint64_t *period_ns)
+{
+    sched_deadline_attr_t attr;
+
+    memset(&attr, 0, sizeof(attr));
+    if(syscall(SYS_sched_getattr, 0, &attr, sizeof(attr), 0) != 0) return -1;
+    if(attr.sched_policy != SCHED_DEADLINE)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    *runtime_ns = attr.sched_runtime;
+    *deadline_ns = attr.sched_deadline;
+    *period_ns = attr.sched_period;
+    return 0;
+}
@@ -0,0 +1,44 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    sched_deadline.h
+ * @brief   This file contains declaration of the SCHED_DEADLINE wrappers
+ * @date    18th October 2026
+ *
+ * glibc before 2.41 has no wrapper for sched_setattr, so it is called through
+ * syscall(). The kernel only accepts a deadline task whose affinity covers its
+ * whole root domain, so the caller has to widen the affinity first. Admission
+ * control fails with EBUSY once the total runtime/period would exceed the RT
+ * bandwidth limit (/proc/sys/kernel/sched_rt_runtime_us).
+ */
+
+#ifndef _SCHED_DEADLINE_H
+#define _SCHED_DEADLINE_H
+
+#include <stdint.h>
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE (6)
+#endif
+
+#define SCHED_DEADLINE_MIN_RUNTIME_NS (1024)   // the kernel rejects anything shorter
+
+/*
+ * @brief Function to make the calling thread a SCHED_DEADLINE task, returns -1 with errno set on failure
+ */
+int sched_deadline_set(uint64_t runtime_ns, uint64_t deadline_ns, uint64_t period_ns);
+
+/*
+ * @brief Function to read back the SCHED_DEADLINE parameters of the calling thread, returns -1 when it is not one
+ */
+int sched_deadline_get(uint64_t *runtime_ns, uint64_t *deadline_ns, uint64_t *period_ns);
+
+#endif
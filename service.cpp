@@ -0,0 +1,423 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    service.cpp
+ * @brief   This file contains definition of the generic sequencer released services
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <atomic>
+
+#include "service.h"
+#include "blackboard.h"
+#include "trace.h"
+#include "capture.h"
+#include "motor.h"
+#include "ultrasonic_sensor.h"
+#include "rm_analysis.h"
+#include "degrade.h"
+#include "rt_time.h"
+#include "sched_deadline.h"
+#include "rt_memory.h"
+
+#define DEGRADE_WINDOW_CYCLES (SEQUENCER_FREQ_HZ)    // the policy looks at one second of releases
+
+#define DEADLINE_BUDGET_MARGIN (1.25)   // measured worst case CPU time to SCHED_DEADLINE runtime
+#define LOCKSTEP_POLL_NS (100000000ULL)  // a lockstep wait checks for shutdown every 100 msec
+
+// Release table, indexed by service id, rates at the 120 Hz sequencer, divisors may be overridden before the start
+static service_desc_t service_table[NUM_SERVICES] =
+{
+    { SERVICE_CAMERA,     PLACE_CAMERA,     8,  30000, camera_init,     camera_release,     camera_fini },      // 15 Hz
+    { SERVICE_MOTOR,      PLACE_MOTOR,      15, 1000,  NULL,            motor_release,      motor_fini },       // 8 Hz
+    { SERVICE_ULTRASONIC, PLACE_ULTRASONIC, 20, 2000,  NULL,            ultrasonic_release, ultrasonic_fini },  // 6 Hz
+};
+
+typedef struct
+{
+    sem_t sem;
+    pthread_t thread;
+    bool started;
+    std::atomic<uint64_t> deadline_ns;      // next release time of the pending periodic release, 0 for none
+    std::atomic<uint32_t> skipped;          // overruns not yet traced by the service thread
+    uint64_t runtime_ns;                    // SCHED_DEADLINE runtime, deadline mode only
+} service_state_t;
+
+static service_state_t service_state[NUM_SERVICES];
+static bool deadline_mode = false;
+static uint64_t deadline_epoch_ns;          // common release timeline of the deadline mode services
+static std::atomic<unsigned long long> current_cycle(0);
+static bool lockstep = false;               // the sequencer waits for every release to complete
+static sem_t idle_sem;                      // posted once per completed periodic release in lockstep
+static unsigned int outstanding = 0;        // periodic releases not completed yet, sequencer only
+
+const service_desc_t *service_desc(int id)
+{
+    return ((id >= 0) && (id < NUM_SERVICES)) ? &service_table[id] : NULL;
+}
+
+static uint64_t service_period_ns(const service_desc_t *desc)
+{
+    return (uint64_t)desc->divisor * NSEC_PER_SEC / SEQUENCER_FREQ_HZ;
+}
+
+// One release of a service, deadline_ns is 0 for an out of period wakeup
+static void service_run(const service_desc_t *desc, service_state_t *state, uint32_t *seq, uint64_t deadline_ns)
+{
+    uint64_t start_ns, stop_ns;
+    rt_ns_t cpu_ns;
+    uint32_t skipped;
+
+    start_ns = service_stats_start(desc->id);
+    desc->release(start_ns, *seq);
+    stop_ns = service_stats_stop(desc->id);
+    (*seq)++;
+    cpu_ns = service_stats[desc->id].last_cpu_ns;
+    trace_emit(desc->id, TRACE_EV_SERVICE, *seq, (cpu_ns > INT32_MAX) ? INT32_MAX : (int32_t)cpu_ns, start_ns, stop_ns);
+
+    // Anything allocated after the first releases is counted, or aborts in strict mode
+    if(*seq == RT_MEMORY_WARMUP_RELEASES) rt_memory_guard(desc->id);
+
+    if(service_stats_deadline(desc->id, stop_ns, deadline_ns))
+        trace_emit(desc->id, TRACE_EV_DEADLINE_MISS, *seq, 0, deadline_ns, stop_ns);
+    skipped = state->skipped.exchange(0, std::memory_order_relaxed);
+    if(skipped) trace_emit(desc->id, TRACE_EV_OVERRUN, *seq, skipped, start_ns, stop_ns);
+}
+
+// Released by the sequencer through the semaphore
+static void service_loop_sequenced(const service_desc_t *desc, service_state_t *state)
+{
+    uint32_t seq = 0;
+
+    for(;;)
+    {
+        sem_wait(&state->sem);
+        if(blackboard_shutdown_requested()) break;
+
+        // Consumed like the release stamp, out of period wakeups have no deadline
+        uint64_t deadline_ns = state->deadline_ns.exchange(0, std::memory_order_relaxed);
+        service_run(desc, state, &seq, deadline_ns);
+        if(lockstep && (deadline_ns != 0)) sem_post(&idle_sem);
+    }
+}
+
+/*
+ * Released by its own absolute timer as a SCHED_DEADLINE task. The semaphore still
+ * brings the out of period wakeups and the shutdown. The releases are on the same
+ * timeline as the sequencer would put them, so the statistics compare directly.
+ */
+static void service_loop_deadline(const service_desc_t *desc, service_state_t *state)
+{
+    uint64_t period_ns = service_period_ns(desc);
+    uint64_t release_ns = deadline_epoch_ns + period_ns, runtime_ns, dl_ns, dl_period_ns, now;
+    struct timespec release_time;
+    cpu_set_t all;
+    uint32_t seq = 0;
+
+    // The kernel only admits a deadline task whose affinity spans its root domain
+    CPU_ZERO(&all);
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &all);
+    sched_setaffinity(0, sizeof(all), &all);
+
+    if(sched_deadline_set(state->runtime_ns, period_ns, period_ns) != 0)
+    {
+        printf("SCHED_DEADLINE refused for %s: %s\r\n", service_name(desc->id), strerror(errno));
+        blackboard_request_shutdown();
+        return;
+    }
+    if(sched_deadline_get(&runtime_ns, &dl_ns, &dl_period_ns) == 0)
+        printf("%s: SCHED_DEADLINE runtime %llu us, deadline %llu us, period %llu us\r\n", service_name(desc->id),
+               (unsigned long long)runtime_ns / NSEC_PER_MICROSEC, (unsigned long long)dl_ns / NSEC_PER_MICROSEC,
+               (unsigned long long)dl_period_ns / NSEC_PER_MICROSEC);
+
+    // A slow init may have run past the first releases, they were never due
+    now = rt_now();
+    while(release_ns <= now) release_ns += period_ns;
+
+    while(!blackboard_shutdown_requested())
+    {
+        ns_to_timespec(release_ns, &release_time);
+        if(sem_clockwait(&state->sem, CLOCK_MONOTONIC, &release_time) == 0)
+        {
+            if(!blackboard_shutdown_requested()) service_run(desc, state, &seq, 0);
+            continue;
+        }
+        if(errno != ETIMEDOUT) continue;
+
+        service_stats_release_at(desc->id, release_ns);
+        service_run(desc, state, &seq, release_ns + period_ns);
+        release_ns += period_ns;
+
+        // Same rule as the sequencer mode, only one late release is kept, older ones are dropped
+        now = rt_now();
+        while(now >= release_ns + period_ns)
+        {
+            service_stats_overrun(desc->id);
+            state->skipped.fetch_add(1, std::memory_order_relaxed);
+            release_ns += period_ns;
+        }
+    }
+}
+
+static void *service_thread(void *arg)
+{
+    const service_desc_t *desc = (const service_desc_t *)arg;
+    service_state_t *state = &service_state[desc->id];
+
+    rt_memory_prefault_stack();
+    if(desc->init) desc->init();
+
+    if(deadline_mode)
+        service_loop_deadline(desc, state);
+    else
+        service_loop_sequenced(desc, state);
+
+    rt_memory_guard(-1);
+    if(desc->fini) desc->fini();
+    return NULL;
+}
+
+int service_use_deadline(const char *budget_trace)
+{
+    static latency_histogram_t exec[NUM_SERVICES];
+    static latency_histogram_t cpu[NUM_SERVICES];
+    rm_task_t recorded[NUM_SERVICES];
+    bool have_config[NUM_SERVICES];
+    unsigned int seq_hz;
+
+    for(int i = 0; i < NUM_SERVICES; i++)
+        service_state[i].runtime_ns = (uint64_t)service_table[i].budget_us * NSEC_PER_MICROSEC;
+
+    if(budget_trace)
+    {
+        if(rm_load_trace(budget_trace, exec, cpu, recorded, have_config, &seq_hz) != 0) return -1;
+        for(int i = 0; i < NUM_SERVICES; i++)
+            // The kernel charges runtime in CPU time, so time spent asleep on echoes needs no budget
+            if(cpu[i].count.load(std::memory_order_relaxed) > 0)
+                service_state[i].runtime_ns = rm_exec_budget(&cpu[i], 0.0) * DEADLINE_BUDGET_MARGIN;
+    }
+
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        uint64_t period_ns = service_period_ns(&service_table[i]);
+
+        if(service_state[i].runtime_ns < SCHED_DEADLINE_MIN_RUNTIME_NS) service_state[i].runtime_ns = SCHED_DEADLINE_MIN_RUNTIME_NS;
+        if(service_state[i].runtime_ns > period_ns)
+        {
+            printf("%s budget %llu us does not fit its %llu us period\r\n", service_name(i),
+                   (unsigned long long)service_state[i].runtime_ns / NSEC_PER_MICROSEC, (unsigned long long)period_ns / NSEC_PER_MICROSEC);
+            return -1;
+        }
+    }
+
+    deadline_mode = true;
+    return 0;
+}
+
+bool service_deadline_mode(void)
+{
+    return deadline_mode;
+}
+
+int service_start_all(void)
+{
+    pthread_attr_t attr;
+    int rc;
+
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        service_state[i].deadline_ns.store(0, std::memory_order_relaxed);
+        service_state[i].skipped.store(0, std::memory_order_relaxed);
+        if(sem_init(&service_state[i].sem, 0, 0))
+        {
+            printf("Failed to initialize the %s semaphore\r\n", service_name(i));
+            return -1;
+        }
+    }
+
+    if(lockstep && sem_init(&idle_sem, 0, 0))
+    {
+        printf("Failed to initialize the lockstep semaphore\r\n");
+        return -1;
+    }
+
+    // Deadline mode services start on the timeline after main's one second startup wait, like the sequencer
+    deadline_epoch_ns = rt_now() + NSEC_PER_SEC;
+
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        const thread_placement_t *place = &placement[service_table[i].placement];
+        uint64_t cpu_mask = 0;
+
+        // Record what the services run with, so a saved trace can be analyzed on its own (see rm_analyze)
+        for(int cpu = 0; cpu < 64; cpu++)
+            if(CPU_ISSET(cpu, &place->cpus)) cpu_mask |= 1ULL << cpu;
+        trace_emit(service_table[i].id, TRACE_EV_RELEASE_CONFIG, service_table[i].divisor, place->priority, cpu_mask, SEQUENCER_FREQ_HZ);
+
+        pthread_attr_init(&attr);
+        placement_set_attr(service_table[i].placement, &attr);
+        rt_memory_stack_attr(&attr);
+        rc = pthread_create(&service_state[i].thread, &attr, service_thread, (void *)&service_table[i]);
+        pthread_attr_destroy(&attr);
+        if(rc != 0)
+        {
+            printf("pthread_create for %s failed\r\n", service_name(i));
+            return -1;
+        }
+        service_state[i].started = true;
+        printf("pthread_create successful for %s\r\n", service_name(i));
+    }
+
+    degrade_init();
+    return 0;
+}
+
+void service_release(unsigned long long seq_cnt)
+{
+    current_cycle.store(seq_cnt, std::memory_order_relaxed);
+
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        service_state_t *state = &service_state[i];
+        unsigned int divisor = service_table[i].divisor;
+
+        if((seq_cnt % divisor) != 0) continue;
+
+        // The last periodic release has not even started, posting again would only make the
+        // service run back to back later, so this one is dropped. The pending deadline is used
+        // rather than the semaphore count, which also holds the out of period wakeups
+        if(state->deadline_ns.load(std::memory_order_relaxed) != 0)
+        {
+            service_stats_overrun(service_table[i].id);
+            state->skipped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        service_stats_release(service_table[i].id);
+        state->deadline_ns.store(rt_now() + (uint64_t)divisor * NSEC_PER_SEC / SEQUENCER_FREQ_HZ, std::memory_order_relaxed);
+        if(lockstep) outstanding++;
+        sem_post(&state->sem);
+    }
+
+    if((seq_cnt % DEGRADE_WINDOW_CYCLES) == 0) degrade_update();
+}
+
+unsigned long long service_cycle(void)
+{
+    return current_cycle.load(std::memory_order_relaxed);
+}
+
+void service_set_lockstep(bool enabled)
+{
+    lockstep = enabled;
+}
+
+void service_wait_idle(void)
+{
+    struct timespec poll_time;
+
+    while(lockstep && (outstanding > 0))
+    {
+        ns_to_timespec(rt_now() + LOCKSTEP_POLL_NS, &poll_time);
+        if(sem_clockwait(&idle_sem, CLOCK_MONOTONIC, &poll_time) == 0)
+            outstanding--;
+        else if(blackboard_shutdown_requested())
+            return;
+    }
+}
+
+int service_parse_divisor(const char *spec)
+{
+    char name[32];
+    unsigned int divisor;
+
+    // service=divisor
+    if((sscanf(spec, "%31[^=]=%u", name, &divisor) != 2) || (divisor == 0))
+    {
+        printf("Bad divisor '%s', expected service=divisor\r\n", spec);
+        return -1;
+    }
+
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        if(strcmp(service_name(i), name) != 0) continue;
+        service_table[i].divisor = divisor;
+        return 0;
+    }
+
+    printf("Unknown service '%s'\r\n", name);
+    return -1;
+}
+
+void service_wake(service_id_t id)
+{
+    sem_post(&service_state[id].sem);
+}
+
+void service_wake_all(void)
+{
+    for(int i = 0; i < NUM_SERVICES; i++)
+        sem_post(&service_state[i].sem);
+}
+
+void service_join_all(void)
+{
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        if(!service_state[i].started) continue;
+        pthread_join(service_state[i].thread, NULL);
+        service_state[i].started = false;
+    }
+}
+
+void service_memory_dump(FILE *out)
+{
+    for(int i = 0; i < NUM_SERVICES; i++)
+        fprintf(out, "%s: %llu allocations after warm-up\n", service_name(i), (unsigned long long)rt_memory_guarded_allocs(i));
+}
+
+void service_print_placement(FILE *out)
+{
+    for(int i = 0; i < NUM_SERVICES; i++)
+        if(service_state[i].started) placement_print_thread(out, service_name(i), service_state[i].thread);
+}
+
+bool service_admission_check(FILE *out, const char *trace_path, double percentile)
+{
+    static latency_histogram_t exec[NUM_SERVICES];
+    static latency_histogram_t cpu[NUM_SERVICES];
+    rm_task_t tasks[NUM_SERVICES], recorded[NUM_SERVICES];
+    bool have_config[NUM_SERVICES];
+    unsigned int seq_hz = 0;
+
+    if(rm_load_trace(trace_path, exec, cpu, recorded, have_config, &seq_hz) != 0) return false;
+
+    // Execution times come from the trace, rates and placement from this run's configuration
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        const thread_placement_t *place = &placement[service_table[i].placement];
+
+        tasks[i].name = service_name(i);
+        tasks[i].divisor = service_table[i].divisor;
+        tasks[i].priority = place->priority;
+        tasks[i].cpus = place->cpus;
+        rm_task_budget(&tasks[i], &exec[i], &cpu[i], percentile);
+    }
+
+    return rm_analysis_report(out, tasks, NUM_SERVICES, SEQUENCER_FREQ_HZ);
+}
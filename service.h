@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    service.h
+ * @brief   This file contains declaration of the generic sequencer released services
+ * @date    18th October 2026
+ *
+ * Every service is a row of the release table in service.cpp: a release function,
+ * a sequencer divisor and a placement. The generic service thread waits for the
+ * release, records the timing and trace once for all services and calls the
+ * release function. Adding a service means adding a row, an id in service_stats.h
+ * and a placement entry; main.cpp and the sequencer do not change.
+ */
+
+#ifndef _SERVICE_H
+#define _SERVICE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "service_stats.h"
+#include "placement.h"
+
+#define SEQUENCER_FREQ_HZ (120)
+
+typedef struct
+{
+    service_id_t id;
+    placement_id_t placement;
+    unsigned int divisor;                           // released every divisor-th sequencer cycle
+    unsigned int budget_us;                         // SCHED_DEADLINE runtime when no trace is given
+    void (*init)(void);                             // optional, runs on the service thread before the first release
+    void (*release)(uint64_t start_ns, uint32_t seq);
+    void (*fini)(void);                             // optional, runs on the service thread after the last release
+} service_desc_t;
+
+/*
+ * @brief Function to get the release table entry of a service
+ */
+const service_desc_t *service_desc(int id);
+
+/*
+ * @brief Function to run the services as SCHED_DEADLINE tasks on their own timers instead of from the sequencer,
+ *        runtimes are the table budgets or the measured maximum of a trace plus a margin, call before service_start_all
+ */
+int service_use_deadline(const char *budget_trace);
+
+/*
+ * @brief Function to check whether the services run as SCHED_DEADLINE tasks
+ */
+bool service_deadline_mode(void);
+
+/*
+ * @brief Function to create all the service threads with their placement, they wait for the first release
+ */
+int service_start_all(void);
+
+/*
+ * @brief Function called by the sequencer on every cycle to release the services that are due
+ */
+void service_release(unsigned long long seq_cnt);
+
+/*
+ * @brief Function to get the last sequencer cycle passed to service_release
+ */
+unsigned long long service_cycle(void);
+
+/*
+ * @brief Function to make every periodic release report its completion, call before service_start_all
+ */
+void service_set_lockstep(bool enabled);
+
+/*
+ * @brief Function to wait until every periodic release handed out so far has completed, lockstep only
+ */
+void service_wait_idle(void);
+
+/*
+ * @brief Function to apply one "service=divisor" override of the release table, before service_start_all.
+ *        Returns -1 on a bad spec
+ */
+int service_parse_divisor(const char *spec);
+
+/*
+ * @brief Function to release a service out of its period, e.g. on an input event
+ */
+void service_wake(service_id_t id);
+
+/*
+ * @brief Function to wake every service after a shutdown request so it can exit
+ */
+void service_wake_all(void);
+
+/*
+ * @brief Function to wait for all the service threads to exit
+ */
+void service_join_all(void);
+
+/*
+ * @brief Function to print the heap allocations every service made once it was past its warm-up releases
+ */
+void service_memory_dump(FILE *out);
+
+/*
+ * @brief Function to print the effective placement of every service thread
+ */
+void service_print_placement(FILE *out);
+
+/*
+ * @brief Function to check the configured rates and placement against the execution times of a previous trace,
+ *        prints the analysis and returns false when a service could miss its deadline
+ */
+bool service_admission_check(FILE *out, const char *trace_path, double percentile);
+
+#endif
@@ -0,0 +1,143 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    service_stats.cpp
+ * @brief   This file contains definition of the per service timing statistics
+ * @date    18th October 2026
+ *
+ */
+
+#include <time.h>
+
+#include "service_stats.h"
+#include "rt_time.h"
+
+service_stats_t service_stats[NUM_SERVICES];
+latency_histogram_t event_latency[NUM_EVENT_LATENCIES];
+
+static const char *service_names[NUM_SERVICES] = { "camera", "motor", "ultrasonic" };
+static const char *event_latency_names[NUM_EVENT_LATENCIES] = { "obstacle->pwm zero", "frame capture->dequeue", "gear change->first frame",
+                                                                "rear obstacle->pwm zero", "rear echo->pwm zero" };
+
+void service_stats_init(void)
+{
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        service_stats[i].name = service_names[i];
+        service_stats[i].release_ns.store(0, std::memory_order_relaxed);
+        service_stats[i].last_start_ns = 0;
+        latency_histogram_init(&service_stats[i].exec_time);
+        latency_histogram_init(&service_stats[i].cpu_time);
+        latency_histogram_init(&service_stats[i].release_latency);
+        latency_histogram_init(&service_stats[i].period);
+        service_stats[i].releases.store(0, std::memory_order_relaxed);
+        service_stats[i].overruns.store(0, std::memory_order_relaxed);
+        service_stats[i].deadline_misses.store(0, std::memory_order_relaxed);
+    }
+
+    for(int i = 0; i < NUM_EVENT_LATENCIES; i++)
+        latency_histogram_init(&event_latency[i]);
+}
+
+const char *service_name(int id)
+{
+    return ((id >= 0) && (id < NUM_SERVICES)) ? service_names[id] : "unknown";
+}
+
+void service_stats_release(service_id_t id)
+{
+    service_stats_release_at(id, rt_now());
+}
+
+void service_stats_release_at(service_id_t id, uint64_t release_ns)
+{
+    service_stats[id].release_ns.store(release_ns, std::memory_order_relaxed);
+    service_stats[id].releases.fetch_add(1, std::memory_order_relaxed);
+}
+
+void service_stats_overrun(service_id_t id)
+{
+    service_stats[id].overruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool service_stats_deadline(service_id_t id, uint64_t stop_ns, uint64_t deadline_ns)
+{
+    if((deadline_ns == 0) || (stop_ns <= deadline_ns)) return false;
+
+    service_stats[id].deadline_misses.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+uint64_t service_stats_start(service_id_t id)
+{
+    service_stats_t *stats = &service_stats[id];
+    uint64_t start_ns = rt_now();
+    uint64_t release_ns = stats->release_ns.exchange(0, std::memory_order_relaxed);
+
+    // The semaphore orders the release stamp before the wakeup. The stamp is consumed
+    // here, so the shutdown post and back-to-back catch up wakeups record nothing
+    if((release_ns != 0) && (start_ns >= release_ns))
+        latency_histogram_record(&stats->release_latency, start_ns - release_ns);
+
+    if(stats->last_start_ns != 0)
+        latency_histogram_record(&stats->period, start_ns - stats->last_start_ns);
+    stats->last_start_ns = start_ns;
+
+    // Execution time is a duration, it comes from the cheaper clock that NTP does not slew
+    stats->exec_start = rt_stopwatch();
+    stats->cpu_start = rt_thread_cpu();
+    return start_ns;
+}
+
+uint64_t service_stats_stop(service_id_t id)
+{
+    service_stats_t *stats = &service_stats[id];
+    rt_ns_t exec_ns = rt_stopwatch() - stats->exec_start;
+
+    // The ultrasonic service sleeps on its echoes, only the CPU time is demand on the core
+    stats->last_cpu_ns = rt_thread_cpu() - stats->cpu_start;
+    latency_histogram_record(&stats->exec_time, exec_ns);
+    latency_histogram_record(&stats->cpu_time, stats->last_cpu_ns);
+    return rt_now();
+}
+
+void service_stats_event_latency(event_latency_id_t id, uint64_t event_ns)
+{
+    uint64_t now = rt_now();
+
+    if(now >= event_ns)
+        latency_histogram_record(&event_latency[id], now - event_ns);
+}
+
+void service_stats_dump(FILE *out)
+{
+    char name[64];
+
+    fprintf(out, "---- service timing ----\n");
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        snprintf(name, sizeof(name), "%s exec", service_stats[i].name);
+        latency_histogram_print(out, name, &service_stats[i].exec_time);
+        snprintf(name, sizeof(name), "%s cpu", service_stats[i].name);
+        latency_histogram_print(out, name, &service_stats[i].cpu_time);
+        snprintf(name, sizeof(name), "%s release->start", service_stats[i].name);
+        latency_histogram_print(out, name, &service_stats[i].release_latency);
+        snprintf(name, sizeof(name), "%s period", service_stats[i].name);
+        latency_histogram_print(out, name, &service_stats[i].period);
+        fprintf(out, "%s: %llu releases, %llu overruns, %llu deadline misses\n", service_stats[i].name,
+                (unsigned long long)service_stats[i].releases.load(std::memory_order_relaxed),
+                (unsigned long long)service_stats[i].overruns.load(std::memory_order_relaxed),
+                (unsigned long long)service_stats[i].deadline_misses.load(std::memory_order_relaxed));
+    }
+    for(int i = 0; i < NUM_EVENT_LATENCIES; i++)
+        latency_histogram_print(out, event_latency_names[i], &event_latency[i]);
+    fflush(out);
+}
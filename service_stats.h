@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    service_stats.h
+ * @brief   This file contains declaration of the per service timing statistics
+ * @date    18th October 2026
+ *
+ */
+
+#ifndef _SERVICE_STATS_H
+#define _SERVICE_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "latency_histogram.h"
+#include "rt_time.h"
+
+typedef enum
+{
+    SERVICE_CAMERA = 0,
+    SERVICE_MOTOR,
+    SERVICE_ULTRASONIC,
+    NUM_SERVICES
+} service_id_t;
+
+typedef enum
+{
+    EVENT_OBSTACLE_STOP = 0,    // forward ultrasonic echo end to both PWM outputs at zero
+    EVENT_FRAME_AGE,            // V4L2 driver capture timestamp to dequeue by the camera service
+    EVENT_GEAR_TO_FRAME,        // gear change to the first fresh reverse frame published
+    EVENT_REAR_OBSTACLE_STOP,   // rear detector frame capture to both PWM outputs at zero
+    EVENT_REAR_ECHO_STOP,       // rear ultrasonic echo end to both PWM outputs at zero
+    NUM_EVENT_LATENCIES
+} event_latency_id_t;
+
+typedef struct
+{
+    const char *name;
+    std::atomic<uint64_t> release_ns;   // written by the sequencer on every release
+    uint64_t last_start_ns;             // only touched by the service thread
+    rt_ns_t exec_start;                 // rt_stopwatch at the start, only touched by the service thread
+    rt_ns_t cpu_start;                  // rt_thread_cpu at the start, only touched by the service thread
+    rt_ns_t last_cpu_ns;                // CPU time of the last release, only touched by the service thread
+    latency_histogram_t exec_time;      // start to stop of one release, on rt_stopwatch
+    latency_histogram_t cpu_time;       // CPU time of one release, the time the service slept left out
+    latency_histogram_t release_latency;// sequencer release to service start
+    latency_histogram_t period;         // start to start of consecutive releases
+    std::atomic<uint64_t> releases;     // periodic releases posted by the sequencer
+    std::atomic<uint64_t> overruns;     // releases skipped because the previous one had not started
+    std::atomic<uint64_t> deadline_misses; // releases that completed after the next release was due
+} service_stats_t;
+
+extern service_stats_t service_stats[NUM_SERVICES];
+extern latency_histogram_t event_latency[NUM_EVENT_LATENCIES];
+
+/*
+ * @brief Function to reset the statistics of all the services
+ */
+void service_stats_init(void);
+
+/*
+ * @brief Function to get the printable name of a service
+ */
+const char *service_name(int id);
+
+/*
+ * @brief Function called by the sequencer right before it posts the service semaphore
+ */
+void service_stats_release(service_id_t id);
+
+/*
+ * @brief Function to record a release at a known time, for services released by their own timer
+ */
+void service_stats_release_at(service_id_t id, uint64_t release_ns);
+
+/*
+ * @brief Function called by the service right after it is released, returns the start time
+ */
+uint64_t service_stats_start(service_id_t id);
+
+/*
+ * @brief Function called by the service at the end of its work to record the execution and CPU time, returns the stop time
+ */
+uint64_t service_stats_stop(service_id_t id);
+
+/*
+ * @brief Function called by the sequencer instead of service_stats_release when the previous release is still pending
+ */
+void service_stats_overrun(service_id_t id);
+
+/*
+ * @brief Function to check a completed release against its deadline, returns true and counts it when it was missed
+ */
+bool service_stats_deadline(service_id_t id, uint64_t stop_ns, uint64_t deadline_ns);
+
+/*
+ * @brief Function to record the latency from an event timestamp to now, each id must have a single writer thread
+ */
+void service_stats_event_latency(event_latency_id_t id, uint64_t event_ns);
+
+/*
+ * @brief Function to print the percentiles of all the services and event latencies
+ */
+void service_stats_dump(FILE *out);
+
+#endif
@@ -0,0 +1,205 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    trace.cpp
+ * @brief   This file contains definition of the asynchronous binary trace logger
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <syslog.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <atomic>
+
+#include "trace.h"
+
+#define TRACE_DRAIN_PERIOD_US (100000)   // drainer wakes up every 100 msec
+
+typedef struct
+{
+    // Producer and consumer indices on their own cache lines
+    alignas(64) std::atomic<uint32_t> head;
+    uint32_t dropped;                        // only written by the producer
+    alignas(64) std::atomic<uint32_t> tail;
+    uint32_t dropped_reported;               // only touched by the drainer
+    alignas(64) trace_record_t records[TRACE_RING_SIZE];
+} trace_ring_t;
+
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+static_assert(sizeof(trace_record_t) == 32, "trace records are written to file as is");
+
+static trace_ring_t trace_rings[NUM_SERVICES];
+static FILE *trace_file = NULL;
+static pthread_t trace_thread;
+static std::atomic<bool> trace_running(false);
+
+static const char *trace_event_names[TRACE_NUM_EVENTS] = { "service", "obstacle", "dropped", "echo_lost", "camera_state", "release_config",
+                                                           "deadline_miss", "overrun", "echo_rejected" };
+
+void trace_emit(service_id_t id, trace_event_t event, uint32_t seq, int32_t arg, uint64_t start_ns, uint64_t stop_ns)
+{
+    trace_ring_t *ring = &trace_rings[id];
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+
+    if((head - ring->tail.load(std::memory_order_acquire)) >= TRACE_RING_SIZE)
+    {
+        ring->dropped++;
+        return;
+    }
+
+    trace_record_t *rec = &ring->records[head & (TRACE_RING_SIZE - 1)];
+    rec->service_id = (uint16_t)id;
+    rec->event = (uint16_t)event;
+    rec->seq = seq;
+    rec->arg = arg;
+    rec->reserved = 0;
+    rec->start_ns = start_ns;
+    rec->stop_ns = stop_ns;
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+const char *trace_event_name(uint16_t event)
+{
+    return (event < TRACE_NUM_EVENTS) ? trace_event_names[event] : "unknown";
+}
+
+static void trace_write(const trace_record_t *rec)
+{
+    if(trace_file)
+    {
+        fwrite(rec, sizeof(*rec), 1, trace_file);
+        return;
+    }
+
+    syslog(LOG_INFO, "%s %s seq=%u arg=%d start=%llu nsec exec=%llu nsec\n",
+           service_name(rec->service_id), trace_event_name(rec->event), rec->seq, rec->arg,
+           (unsigned long long)rec->start_ns, (unsigned long long)(rec->stop_ns - rec->start_ns));
+}
+
+static void trace_drain(void)
+{
+    for(int i = 0; i < NUM_SERVICES; i++)
+    {
+        trace_ring_t *ring = &trace_rings[i];
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint32_t head = ring->head.load(std::memory_order_acquire);
+
+        while(tail != head)
+        {
+            trace_write(&ring->records[tail & (TRACE_RING_SIZE - 1)]);
+            tail++;
+            ring->tail.store(tail, std::memory_order_release);
+        }
+
+        // The drop counter is read racily, a late increment is simply reported next time
+        uint32_t dropped = *(volatile uint32_t *)&ring->dropped;
+        if(dropped != ring->dropped_reported)
+        {
+            trace_record_t rec;
+            memset(&rec, 0, sizeof(rec));
+            rec.service_id = (uint16_t)i;
+            rec.event = TRACE_EV_DROPPED;
+            rec.arg = (int32_t)(dropped - ring->dropped_reported);
+            trace_write(&rec);
+            ring->dropped_reported = dropped;
+        }
+    }
+
+    if(trace_file) fflush(trace_file);
+}
+
+static void *trace_drainer(void *arg)
+{
+    (void)arg;
+
+    while(trace_running.load(std::memory_order_relaxed))
+    {
+        usleep(TRACE_DRAIN_PERIOD_US);
+        trace_drain();
+    }
+
+    trace_drain();
+    return NULL;
+}
+
+int trace_start(const char *path)
+{
+    pthread_attr_t attr;
+    struct sched_param param;
+    int rc;
+
+    if(path)
+    {
+        trace_file_header_t header;
+
+        trace_file = fopen(path, "wb");
+        if(!trace_file)
+        {
+            perror("trace file");
+            return -1;
+        }
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+        header.version = TRACE_FILE_VERSION;
+        header.record_size = sizeof(trace_record_t);
+        fwrite(&header, sizeof(header), 1, trace_file);
+    }
+
+    // The drainer must never compete with the RT services
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    param.sched_priority = 0;
+    pthread_attr_setschedparam(&attr, &param);
+
+    trace_running.store(true, std::memory_order_relaxed);
+    rc = pthread_create(&trace_thread, &attr, trace_drainer, NULL);
+    pthread_attr_destroy(&attr);
+    if(rc != 0)
+    {
+        trace_running.store(false, std::memory_order_relaxed);
+        printf("pthread_create for trace drainer failed\r\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+void trace_stop(void)
+{
+    if(!trace_running.exchange(false))
+        return;
+
+    pthread_join(trace_thread, NULL);
+
+    if(trace_file)
+    {
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+
+    if(trace_dropped() > 0)
+        printf("Trace dropped %llu records\n", (unsigned long long)trace_dropped());
+}
+
+uint64_t trace_dropped(void)
+{
+    uint64_t total = 0;
+
+    for(int i = 0; i < NUM_SERVICES; i++)
+        total += *(volatile uint32_t *)&trace_rings[i].dropped;
+
+    return total;
+}
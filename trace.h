@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    trace.h
+ * @brief   This file contains declaration of the asynchronous binary trace logger
+ * @date    18th October 2026
+ *
+ * Every service owns one single producer/single consumer ring of fixed size
+ * records. Emitting a record is a handful of stores and never blocks, a full
+ * ring drops the record and counts it. A low priority drainer thread empties
+ * the rings into syslog or into a binary file read back with trace_decode.
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "service_stats.h"
+
+#define TRACE_RING_SIZE (1024)       // records per service, must be a power of two
+#define TRACE_FILE_MAGIC "PPTRACE1"
+#define TRACE_FILE_VERSION (2)
+
+typedef enum
+{
+    TRACE_EV_SERVICE = 0,    // one service release, start/stop of the work, arg = CPU time in ns
+    TRACE_EV_OBSTACLE,       // obstacle detected, arg = distance in mm
+    TRACE_EV_DROPPED,        // written by the drainer, arg = records lost since the last one
+    TRACE_EV_ECHO_LOST,      // ultrasonic ping without a usable echo, arg = echo_status_t
+    TRACE_EV_CAMERA_STATE,   // camera entered a new state, arg = 0 standby, 1 active
+    TRACE_EV_RELEASE_CONFIG, // written once at startup, seq = sequencer divisor, arg = priority,
+                             // start_ns = mask of the first 64 cores, stop_ns = sequencer rate in Hz
+    TRACE_EV_DEADLINE_MISS,  // release completed late, start_ns = deadline, stop_ns = completion
+    TRACE_EV_OVERRUN,        // releases the sequencer skipped since the last one ran, arg = count
+    TRACE_EV_ECHO_REJECTED,  // ping dropped as a spurious echo by the range filter, arg = distance in mm
+    TRACE_NUM_EVENTS
+} trace_event_t;
+
+typedef struct
+{
+    uint16_t service_id;
+    uint16_t event;
+    uint32_t seq;
+    int32_t arg;
+    uint32_t reserved;
+    uint64_t start_ns;
+    uint64_t stop_ns;
+} trace_record_t;
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+} trace_file_header_t;
+
+/*
+ * @brief Function to add one record to the ring of the calling service, never blocks
+ */
+void trace_emit(service_id_t id, trace_event_t event, uint32_t seq, int32_t arg, uint64_t start_ns, uint64_t stop_ns);
+
+/*
+ * @brief Function to start the drainer thread, records go to the binary file if path is not NULL, else to syslog
+ */
+int trace_start(const char *path);
+
+/*
+ * @brief Function to stop the drainer thread after a final drain
+ */
+void trace_stop(void);
+
+/*
+ * @brief Function to get the total number of records dropped on full rings
+ */
+uint64_t trace_dropped(void);
+
+/*
+ * @brief Function to get the printable name of a trace event
+ */
+const char *trace_event_name(uint16_t event);
+
+#endif
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    trace_decode.cpp
+ * @brief   This file contains the offline decoder for the binary trace files written by main -t
+ * @date    18th October 2026
+ *
+ * Usage: trace_decode <trace file>
+ * Prints one CSV line per record: service,event,seq,arg,start_ns,stop_ns,exec_ns
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+int main(int argc, char *argv[])
+{
+    trace_file_header_t header;
+    trace_record_t rec;
+    unsigned long long records = 0, dropped = 0;
+    FILE *in;
+
+    if(argc != 2)
+    {
+        printf("Usage: %s <trace file>\n", argv[0]);
+        exit(-1);
+    }
+
+    in = fopen(argv[1], "rb");
+    if(!in)
+    {
+        perror("trace file");
+        exit(-1);
+    }
+
+    if((fread(&header, sizeof(header), 1, in) != 1) ||
+       (memcmp(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic)) != 0) ||
+       (header.version != TRACE_FILE_VERSION) ||
+       (header.record_size != sizeof(trace_record_t)))
+    {
+        printf("%s is not a version %d trace file\n", argv[1], TRACE_FILE_VERSION);
+        exit(-1);
+    }
+
+    printf("service,event,seq,arg,start_ns,stop_ns,exec_ns\n");
+    while(fread(&rec, sizeof(rec), 1, in) == 1)
+    {
+        printf("%s,%s,%u,%d,%llu,%llu,%llu\n", service_name(rec.service_id), trace_event_name(rec.event),
+               rec.seq, rec.arg, (unsigned long long)rec.start_ns, (unsigned long long)rec.stop_ns,
+               (unsigned long long)(rec.stop_ns - rec.start_ns));
+        records++;
+        if(rec.event == TRACE_EV_DROPPED) dropped += rec.arg;
+    }
+
+    fprintf(stderr, "%llu records, %llu dropped\n", records, dropped);
+    fclose(in);
+    return 0;
+}
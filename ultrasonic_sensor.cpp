@@ -16,87 +16,251 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
 #include <syslog.h>
-#include <wiringPi.h>
 #include <semaphore.h>
 #include <pthread.h>
 
+#include "ultrasonic_sensor.h"
 #include "motor.h"
-#include "time_stamp.h"
-
-// Define GPIO pins for Trigger and Echo pins
-#define TRIG 15
-#define ECHO 16
-#define DISTANCE_THRESHOLD 7
-
-sem_t sem_ultrasonic;
-extern bool is_forward;
-extern bool is_reverse;
-extern bool abortS3;
-
-void setup_ultasonic_sensor() {
-    wiringPiSetup();
-    pinMode(TRIG, OUTPUT);
-    pinMode(ECHO, INPUT);
-
-    // Ensure the trigger pin is low
-    digitalWrite(TRIG, LOW);
-    delay(30);
+#include "rt_time.h"
+#include "service_stats.h"
+#include "trace.h"
+#include "echo_capture.h"
+#include "blackboard.h"
+#include "record.h"
+#include "hal.h"
+#include "range_filter.h"
+#include "service.h"
+
+#define ULTRASONIC_DRIVE_SPEED_MM_S (MOTOR_FORWARD_DUTY * MOTOR_FULL_DUTY_SPEED_MM_S / 1023)   // closing speed of the forward and reverse command
+#define ULTRASONIC_SLOT_PITCH_NS (ECHO_TIMEOUT_NS)   // trigger to trigger of consecutive slots, the burst of the first has died out by then
+
+static_assert(NUM_ULTRASONIC_SENSORS <= BLACKBOARD_MAX_RANGES, "the blackboard has no room for every sensor");
+
+// The front sensor fires on its own first, the angled pair points apart and shares the next slot
+static const ultrasonic_desc_t ultrasonic_table[NUM_ULTRASONIC_SENSORS] =
+{
+    { ULTRASONIC_FRONT,       "front",       GEAR_FORWARD, 0,   0 },
+    { ULTRASONIC_FRONT_LEFT,  "front_left",  GEAR_FORWARD, 30,  1 },
+    { ULTRASONIC_FRONT_RIGHT, "front_right", GEAR_FORWARD, -30, 1 },
+    { ULTRASONIC_REAR,        "rear",        GEAR_REVERSE, 0,   0 },
+};
+
+typedef struct
+{
+    echo_source_t echo;
+    bool fitted;              // an echo source is open
+    range_filter_t filter;
+    int32_t drive_mm_s;       // closing speed of the drive command along the beam
+    bool stop;                // last decision
+} ultrasonic_state_t;
+
+// Only touched by the ultrasonic service after the setup
+static ultrasonic_state_t sensors[NUM_ULTRASONIC_SENSORS];
+static ultrasonic_ranges_t ranges;
+static int num_slots = 0;
+
+const ultrasonic_desc_t *ultrasonic_desc(int id)
+{
+    return ((id >= 0) && (id < NUM_ULTRASONIC_SENSORS)) ? &ultrasonic_table[id] : NULL;
+}
+
+void setup_ultasonic_sensor(bool simulate, int sim_distance_mm) {
+    // Every sensor pings once per release, -d may have changed the table rate
+    uint64_t interval_ns = (uint64_t)service_desc(SERVICE_ULTRASONIC)->divisor * NSEC_PER_SEC / SEQUENCER_FREQ_HZ;
+
+    for(int i = 0; i < NUM_ULTRASONIC_SENSORS; i++)
+    {
+        const ultrasonic_desc_t *desc = &ultrasonic_table[i];
+        ultrasonic_state_t *sensor = &sensors[i];
+
+        range_filter_init(&sensor->filter, interval_ns);
+        sensor->drive_mm_s = (int32_t)(ULTRASONIC_DRIVE_SPEED_MM_S * cos(desc->angle_deg * M_PI / 180.0));
+        sensor->stop = false;
+        ranges.distance_mm[i] = -1;
+        ranges.measured_ns[i] = 0;
+        if(desc->slot >= num_slots) num_slots = desc->slot + 1;
+
+        if(replay_active())
+        {
+            // No trigger pin to drive, the pings come from the recording
+            sensor->fitted = (echo_source_open_replay(&sensor->echo, i) == 0);
+            if(sensor->fitted) printf("Ultrasonic %s echo replayed\r\n", desc->name);
+        }
+        else if(!hal()->echo_fitted(i))
+        {
+            sensor->fitted = false;
+        }
+        else if(simulate)
+        {
+            echo_source_open_sim(&sensor->echo, sim_distance_mm);
+            sensor->fitted = true;
+            printf("Ultrasonic %s echo simulated at %d mm\r\n", desc->name, sim_distance_mm);
+        }
+        else if(hal()->open_echo(i, &sensor->echo) < 0)
+        {
+            printf("Failed to open the echo line of the %s sensor\r\n", desc->name);
+            exit(-1);
+        }
+        else
+        {
+            sensor->fitted = true;
+        }
+
+        if(sensor->fitted && record_enabled()) echo_source_record(&sensor->echo, i);
+        if(sensor->fitted) ranges.fitted_mask |= 1u << i;
+    }
+    ranges.rear_obstacle = false;
+}
+
+// Stop decision on the filtered range, returns true when the sensor newly asks to stop
+static bool ultrasonic_decide(int id, uint64_t start_ns, uint32_t seq)
+{
+	ultrasonic_state_t *sensor = &sensors[id];
+	range_decision_t decision;
+	bool newly_detected;
+
+	range_filter_decide(&sensor->filter, rt_now(), ULTRASONIC_STOP_DISTANCE_MM, sensor->drive_mm_s,
+	                    MOTOR_BRAKE_TAU_S, &decision);
+
+	newly_detected = decision.stop && !sensor->stop;
+	sensor->stop = decision.stop;
+	// Published with the time of the last accepted ping so it still ages
+	ranges.distance_mm[id] = decision.range_mm;
+	ranges.measured_ns[id] = sensor->filter.last_ns;
+	if(sensor->stop) trace_emit(SERVICE_ULTRASONIC, TRACE_EV_OBSTACLE, seq, decision.range_mm, start_ns, sensor->filter.last_ns);
+	return newly_detected;
+}
+
+// One ping outcome of one sensor, returns true when the sensor newly asks to stop
+static bool ultrasonic_ping(int id, const echo_result_t *result, uint64_t start_ns, uint32_t seq)
+{
+	ultrasonic_state_t *sensor = &sensors[id];
+	long distance_mm;
+
+	if(result->status == ECHO_OK)
+	{
+		// Calculate the distance, a spurious echo only moves the prediction on
+		distance_mm = result->pulse_ns / ECHO_NSEC_PER_MM;
+		if(!range_filter_update(&sensor->filter, distance_mm, result->echo_end_ns))
+			trace_emit(SERVICE_ULTRASONIC, TRACE_EV_ECHO_REJECTED, seq, distance_mm, start_ns, result->echo_end_ns);
+		return sensor->filter.tracking && ultrasonic_decide(id, start_ns, seq);
+	}
+	else if(result->status == ECHO_OUT_OF_RANGE)
+	{
+		// Nothing within range, the sensor kept the echo line high
+		range_filter_reset(&sensor->filter);
+		sensor->stop = false;
+		ranges.distance_mm[id] = -1;
+		ranges.measured_ns[id] = rt_now();
+		return false;
+	}
+
+	// No usable reading, the prediction moves on and the reading ages
+	trace_emit(SERVICE_ULTRASONIC, TRACE_EV_ECHO_LOST, seq, result->status, start_ns, rt_now());
+	return sensor->filter.tracking && ultrasonic_decide(id, start_ns, seq);
 }
 
-void *ultrasonic_sensor_service(void *threadp) {
-    struct timespec start = {0,0};
-    struct timespec stop = {0,0};
-    static struct timespec wcet = {0,0};
-    struct timespec time_taken = {0,0};
-    unsigned long ultrasonic_sensor_service_count = 0;
-    printf("Distance Measurement In Progress\n");
-
-    while (!abortS3) {
-		sem_wait(&sem_ultrasonic);
-		if(is_forward == true)
+// The sensor faces away from the gear, its last reading says nothing about the path
+static void ultrasonic_idle(int id)
+{
+	range_filter_reset(&sensors[id].filter);
+	sensors[id].stop = false;
+	ranges.distance_mm[id] = -1;
+	ranges.measured_ns[id] = 0;
+}
+
+// The forward sensors together: the nearest range, any stop, and as old as the oldest of them
+static void ultrasonic_publish(gear_t gear)
+{
+	int32_t distance_mm = -1;
+	uint64_t measured_ns = UINT64_MAX;
+	bool obstacle = false;
+
+	ranges.rear_obstacle = false;
+	for(int i = 0; i < NUM_ULTRASONIC_SENSORS; i++)
+	{
+		if(!sensors[i].fitted) continue;
+		if(ultrasonic_table[i].facing == GEAR_REVERSE)
 		{
-			clock_gettime(CLOCK_REALTIME, &start);
-			struct timeval detection_start, detection_end;
-			long travel_time, distance;
-
-			// Triggering the sensor for 10 microseconds
-			digitalWrite(TRIG, HIGH);
-			delayMicroseconds(10);
-			digitalWrite(TRIG, LOW);
-
-			// Wait for the echo start
-			while (digitalRead(ECHO) == LOW);
-
-			// Record time of signal return
-			gettimeofday(&detection_start, NULL);
-			while (digitalRead(ECHO) == HIGH);
-			gettimeofday(&detection_end, NULL);
-
-			// Calculate the distance
-			travel_time = (detection_end.tv_sec - detection_start.tv_sec) * 1000000L + detection_end.tv_usec - detection_start.tv_usec;
-			distance = travel_time / 58;
-			if(distance < DISTANCE_THRESHOLD)
-			{
-				syslog(LOG_INFO, "Distance: %d cm\n", distance);
-				is_obstacle_detected = true;
-			}
-			else
+			ranges.rear_obstacle |= sensors[i].stop;
+			continue;
+		}
+
+		obstacle |= sensors[i].stop;
+		if((ranges.distance_mm[i] >= 0) && ((distance_mm < 0) || (ranges.distance_mm[i] < distance_mm))) distance_mm = ranges.distance_mm[i];
+		if(ranges.measured_ns[i] < measured_ns) measured_ns = ranges.measured_ns[i];
+	}
+
+	blackboard_set_ranges(&ranges);
+	// A zero timestamp makes motor_service wait for a fresh reading after the switch back to forward
+	blackboard_set_front(distance_mm, obstacle, ((gear == GEAR_FORWARD) && (measured_ns != UINT64_MAX)) ? measured_ns : 0);
+}
+
+void ultrasonic_release(uint64_t start_ns, uint32_t seq) {
+	gear_t gear = blackboard_gear();
+	echo_source_t *group[NUM_ULTRASONIC_SENSORS];
+	echo_result_t results[NUM_ULTRASONIC_SENSORS];
+	int members[NUM_ULTRASONIC_SENSORS];
+	uint64_t trigger_ns = 0, detection_ns = 0;
+	event_latency_id_t stop_event = EVENT_OBSTACLE_STOP;
+	struct timespec wakeup;
+	bool newly_detected;
+	int count;
+
+	for(int i = 0; i < NUM_ULTRASONIC_SENSORS; i++)
+		if(ultrasonic_table[i].facing != gear) ultrasonic_idle(i);
+
+	for(int slot = 0; slot < num_slots; slot++)
+	{
+		count = 0;
+		for(int i = 0; i < NUM_ULTRASONIC_SENSORS; i++)
+		{
+			if(!sensors[i].fitted || (ultrasonic_table[i].facing != gear) || (ultrasonic_table[i].slot != slot)) continue;
+			members[count] = i;
+			group[count++] = &sensors[i].echo;
+		}
+		if(count == 0) continue;
+
+		// Let the burst of the previous slot die out so it is not taken for an echo of this one
+		if((trigger_ns != 0) && !replay_fast())
+		{
+			ns_to_timespec(trigger_ns + ULTRASONIC_SLOT_PITCH_NS, &wakeup);
+			while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL) == EINTR);
+		}
+
+		// Trigger the whole slot and sleep until all the echo edges arrive or the deadline passes
+		trigger_ns = rt_now();
+		echo_capture_measure_group(group, count, ECHO_TIMEOUT_NS, results);
+
+		newly_detected = false;
+		for(int k = 0; k < count; k++)
+		{
+			if(ultrasonic_ping(members[k], &results[k], start_ns, seq))
 			{
-				is_obstacle_detected = false;
+				newly_detected = true;
+				detection_ns = sensors[members[k]].filter.last_ns;
+				stop_event = (ultrasonic_table[members[k]].facing == GEAR_REVERSE) ? EVENT_REAR_ECHO_STOP : EVENT_OBSTACLE_STOP;
 			}
-		        clock_gettime( CLOCK_REALTIME, &stop);
-		        delta_t(&stop, &start, &time_taken);
-			ultrasonic_sensor_service_count++;
-		        if(check_wcet(&time_taken, &wcet))
-		        {
-			    syslog(LOG_INFO, "sensor wcet: %lu sec, %lu msec (%lu microsec), ((%lu nanosec))\n\n", wcet.tv_sec, (wcet.tv_nsec / NSEC_PER_MSEC), (wcet.tv_nsec / NSEC_PER_MICROSEC),wcet.tv_nsec);
-		        }
-			syslog(LOG_CRIT, "ultrasonic_sensor_service_count = %lu , timestamp: %lu sec, %lu msec (%lu microsec), ((%lu nanosec))\n\n", ultrasonic_sensor_service_count, wcet.tv_sec, (wcet.tv_nsec / NSEC_PER_MSEC), (wcet.tv_nsec / NSEC_PER_MICROSEC),wcet.tv_nsec);
 		}
-    }
-    
-    syslog(LOG_INFO, "Sensor stopped\n");
 
-    pthread_exit(NULL);
+		// Publish after every slot so the first one is not held back by the later ones.
+		// Publish first so a motor_service run after the stop sees it, then stop
+		// right away instead of waiting up to 125 msec for the motor release
+		ultrasonic_publish(gear);
+		if(newly_detected) motor_emergency_stop(stop_event, detection_ns);
+	}
+
+	// Nothing fired, still show the idle sensors
+	if(trigger_ns == 0) ultrasonic_publish(gear);
+}
+
+void ultrasonic_fini(void) {
+    for(int i = 0; i < NUM_ULTRASONIC_SENSORS; i++)
+        if(sensors[i].fitted) echo_source_close(&sensors[i].echo);
+    syslog(LOG_INFO, "Sensor stopped\n");
 }
@@ -15,17 +15,57 @@
  *
  */
 
+#ifndef _ULTRASONIC_SENSOR_H
+#define _ULTRASONIC_SENSOR_H
+
 #include <stdio.h>
-#include <wiringPi.h>
+#include <stdint.h>
+
+#include "blackboard.h"
 
-extern sem_t sem_ultrasonic;
+#define ULTRASONIC_STOP_DISTANCE_MM (70)   // gap to keep to an obstacle
 
 /*
- * @brief Function to setup the ultrasonic sensor
+ * The sensors of the array. Every release fires the sensors that face along the
+ * current gear, one slot after the other. The sensors of one slot are triggered
+ * together, so only sensors whose cones do not overlap share a slot.
  */
-void setup_ultasonic_sensor();
+typedef enum
+{
+    ULTRASONIC_FRONT = 0,
+    ULTRASONIC_FRONT_LEFT,
+    ULTRASONIC_FRONT_RIGHT,
+    ULTRASONIC_REAR,
+    NUM_ULTRASONIC_SENSORS
+} ultrasonic_id_t;
+
+typedef struct
+{
+    ultrasonic_id_t id;
+    const char *name;
+    gear_t facing;        // the gear the sensor looks along
+    int angle_deg;        // off the axis of the vehicle, positive to the left
+    int slot;             // firing slot within a release
+} ultrasonic_desc_t;
 
 /*
- * @brief The ultrasonic sensor service to detect the obstacles and set the is_obstacle_detected flag
+ * @brief Function to get the table entry of a sensor
  */
-void *ultrasonic_sensor_service(void *threadp);
+const ultrasonic_desc_t *ultrasonic_desc(int id);
+
+/*
+ * @brief Function to setup the sensors the backend has fitted, or simulated echoes at the given distance
+ */
+void setup_ultasonic_sensor(bool simulate, int sim_distance_mm);
+
+/*
+ * @brief One ultrasonic sensor service release, fires the sensors facing along the gear and publishes their ranges on the blackboard
+ */
+void ultrasonic_release(uint64_t start_ns, uint32_t seq);
+
+/*
+ * @brief Function to close the echo sources once the ultrasonic service is shut down
+ */
+void ultrasonic_fini(void);
+
+#endif
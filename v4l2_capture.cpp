@@ -0,0 +1,277 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    v4l2_capture.cpp
+ * @brief   This file contains definition of the zero copy V4L2 mmap streaming capture
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#include "v4l2_capture.h"
+#include "rt_time.h"
+
+static int xioctl(int fd, unsigned long request, void *arg)
+{
+    int rc;
+
+    do
+    {
+        rc = ioctl(fd, request, arg);
+    } while((rc < 0) && (errno == EINTR));
+
+    return rc;
+}
+
+int v4l2_capture_open(v4l2_capture_t *cap, const char *device, int width, int height, uint32_t pixfmt, unsigned num_buffers)
+{
+    struct v4l2_capability caps;
+    struct v4l2_format fmt;
+    struct v4l2_requestbuffers req;
+
+    memset(cap, 0, sizeof(*cap));
+    for(unsigned i = 0; i < V4L2_MAX_BUFFERS; i++)
+        cap->buffers[i].dmabuf_fd = -1;
+
+    cap->fd = open(device, O_RDWR | O_NONBLOCK);
+    if(cap->fd < 0)
+    {
+        perror("v4l2 open");
+        return -1;
+    }
+
+    if((xioctl(cap->fd, VIDIOC_QUERYCAP, &caps) < 0) ||
+       !(caps.capabilities & V4L2_CAP_VIDEO_CAPTURE) || !(caps.capabilities & V4L2_CAP_STREAMING))
+    {
+        printf("%s is not a streaming capture device\r\n", device);
+        goto fail;
+    }
+
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = width;
+    fmt.fmt.pix.height = height;
+    fmt.fmt.pix.pixelformat = pixfmt;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if(xioctl(cap->fd, VIDIOC_S_FMT, &fmt) < 0)
+    {
+        perror("VIDIOC_S_FMT");
+        goto fail;
+    }
+
+    // The driver may adjust the request, every later stage is sized for the one we asked for
+    if(fmt.fmt.pix.pixelformat != pixfmt)
+    {
+        printf("v4l2: pixel format not supported by %s\r\n", device);
+        goto fail;
+    }
+    if(((int)fmt.fmt.pix.width != width) || ((int)fmt.fmt.pix.height != height))
+    {
+        printf("v4l2: %s gives %ux%u frames instead of %dx%d\r\n", device, fmt.fmt.pix.width, fmt.fmt.pix.height, width, height);
+        goto fail;
+    }
+    cap->width = fmt.fmt.pix.width;
+    cap->height = fmt.fmt.pix.height;
+    cap->stride = (pixfmt == V4L2_PIX_FMT_MJPEG) ? 0 : fmt.fmt.pix.bytesperline;
+    cap->pixfmt = pixfmt;
+
+    if(num_buffers > V4L2_MAX_BUFFERS) num_buffers = V4L2_MAX_BUFFERS;
+    memset(&req, 0, sizeof(req));
+    req.count = num_buffers;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if((xioctl(cap->fd, VIDIOC_REQBUFS, &req) < 0) || (req.count < 2))
+    {
+        perror("VIDIOC_REQBUFS");
+        goto fail;
+    }
+    cap->num_buffers = (req.count > V4L2_MAX_BUFFERS) ? V4L2_MAX_BUFFERS : req.count;
+
+    for(unsigned i = 0; i < cap->num_buffers; i++)
+    {
+        struct v4l2_buffer buf;
+        struct v4l2_exportbuffer expbuf;
+
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if(xioctl(cap->fd, VIDIOC_QUERYBUF, &buf) < 0)
+        {
+            perror("VIDIOC_QUERYBUF");
+            goto fail;
+        }
+
+        // Frame age and the gear change wait compare the buffer timestamp with rt_now()
+        if(i == 0)
+        {
+            cap->monotonic_ts = (buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+            if(!cap->monotonic_ts)
+                printf("v4l2: %s does not stamp buffers on CLOCK_MONOTONIC, using the dequeue time\r\n", device);
+        }
+
+        cap->buffers[i].length = buf.length;
+        cap->buffers[i].start = mmap(NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, cap->fd, buf.m.offset);
+        if(cap->buffers[i].start == MAP_FAILED)
+        {
+            cap->buffers[i].start = NULL;
+            perror("v4l2 mmap");
+            goto fail;
+        }
+
+        // DMABUF export is optional, older UVC drivers do not support it
+        memset(&expbuf, 0, sizeof(expbuf));
+        expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        expbuf.index = i;
+        expbuf.flags = O_RDONLY | O_CLOEXEC;
+        if(xioctl(cap->fd, VIDIOC_EXPBUF, &expbuf) == 0)
+            cap->buffers[i].dmabuf_fd = expbuf.fd;
+    }
+
+    printf("v4l2: %s %dx%d %s, %u buffers%s\r\n", device, cap->width, cap->height,
+           (pixfmt == V4L2_PIX_FMT_MJPEG) ? "MJPEG" : "YUYV", cap->num_buffers,
+           (cap->buffers[0].dmabuf_fd >= 0) ? ", DMABUF exported" : "");
+    return 0;
+
+fail:
+    v4l2_capture_close(cap);
+    return -1;
+}
+
+int v4l2_capture_start(v4l2_capture_t *cap)
+{
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    if(cap->streaming) return 0;
+
+    for(unsigned i = 0; i < cap->num_buffers; i++)
+    {
+        struct v4l2_buffer buf;
+
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if(xioctl(cap->fd, VIDIOC_QBUF, &buf) < 0)
+        {
+            perror("VIDIOC_QBUF");
+            return -1;
+        }
+    }
+
+    if(xioctl(cap->fd, VIDIOC_STREAMON, &type) < 0)
+    {
+        perror("VIDIOC_STREAMON");
+        return -1;
+    }
+
+    cap->streaming = true;
+    return 0;
+}
+
+int v4l2_capture_stop(v4l2_capture_t *cap)
+{
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    if(!cap->streaming) return 0;
+
+    // STREAMOFF also returns every queued buffer to user space
+    if(xioctl(cap->fd, VIDIOC_STREAMOFF, &type) < 0)
+    {
+        perror("VIDIOC_STREAMOFF");
+        return -1;
+    }
+
+    cap->streaming = false;
+    return 0;
+}
+
+int v4l2_capture_dequeue(v4l2_capture_t *cap, v4l2_frame_t *frame, int timeout_ms)
+{
+    struct pollfd pfd = { cap->fd, POLLIN, 0 };
+    struct v4l2_buffer buf;
+    int rc;
+
+    do
+    {
+        rc = poll(&pfd, 1, timeout_ms);
+    } while((rc < 0) && (errno == EINTR));
+
+    if(rc <= 0) return rc;
+
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if(xioctl(cap->fd, VIDIOC_DQBUF, &buf) < 0)
+    {
+        if(errno == EAGAIN) return 0;
+        perror("VIDIOC_DQBUF");
+        return -1;
+    }
+
+    frame->data = (const uint8_t *)cap->buffers[buf.index].start;
+    frame->size = buf.bytesused;
+    frame->width = cap->width;
+    frame->height = cap->height;
+    frame->stride = cap->stride;
+    frame->pixfmt = cap->pixfmt;
+    if(cap->monotonic_ts && ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC))
+        frame->timestamp_ns = ((uint64_t)buf.timestamp.tv_sec * NSEC_PER_SEC) + ((uint64_t)buf.timestamp.tv_usec * NSEC_PER_MICROSEC);
+    else
+        frame->timestamp_ns = rt_now();
+    frame->sequence = buf.sequence;
+    frame->index = buf.index;
+    frame->dmabuf_fd = cap->buffers[buf.index].dmabuf_fd;
+    return 1;
+}
+
+int v4l2_capture_requeue(v4l2_capture_t *cap, const v4l2_frame_t *frame)
+{
+    struct v4l2_buffer buf;
+
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = frame->index;
+    if(xioctl(cap->fd, VIDIOC_QBUF, &buf) < 0)
+    {
+        perror("VIDIOC_QBUF");
+        return -1;
+    }
+
+    return 0;
+}
+
+void v4l2_capture_close(v4l2_capture_t *cap)
+{
+    if(cap->fd < 0) return;
+
+    v4l2_capture_stop(cap);
+
+    for(unsigned i = 0; i < V4L2_MAX_BUFFERS; i++)
+    {
+        if(cap->buffers[i].dmabuf_fd >= 0) close(cap->buffers[i].dmabuf_fd);
+        if(cap->buffers[i].start) munmap(cap->buffers[i].start, cap->buffers[i].length);
+        cap->buffers[i].dmabuf_fd = -1;
+        cap->buffers[i].start = NULL;
+    }
+
+    close(cap->fd);
+    cap->fd = -1;
+}
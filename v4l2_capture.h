@@ -0,0 +1,96 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    v4l2_capture.h
+ * @brief   This file contains declaration of the zero copy V4L2 mmap streaming capture
+ * @date    18th October 2026
+ *
+ * Frames are handed out as views over the mmap'd driver buffers. A frame stays
+ * valid until it is given back with v4l2_capture_requeue, holding it longer
+ * only starves the driver of buffers, it never copies.
+ */
+
+#ifndef _V4L2_CAPTURE_H
+#define _V4L2_CAPTURE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <linux/videodev2.h>
+
+#define V4L2_MAX_BUFFERS (8)
+
+typedef struct
+{
+    const uint8_t *data;     // view over the driver buffer
+    size_t size;             // bytes used in the buffer
+    int width;
+    int height;
+    int stride;              // bytes per line, 0 for compressed formats
+    uint32_t pixfmt;         // V4L2_PIX_FMT_YUYV or V4L2_PIX_FMT_MJPEG
+    uint64_t timestamp_ns;   // driver capture timestamp, CLOCK_MONOTONIC, dequeue time for a driver without one
+    uint32_t sequence;
+    int index;               // driver buffer index
+    int dmabuf_fd;           // exported DMABUF of the buffer, -1 where not supported
+} v4l2_frame_t;
+
+typedef struct
+{
+    void *start;
+    size_t length;
+    int dmabuf_fd;
+} v4l2_buffer_map_t;
+
+typedef struct
+{
+    int fd;
+    int width;
+    int height;
+    int stride;
+    uint32_t pixfmt;
+    unsigned num_buffers;
+    bool streaming;
+    bool monotonic_ts;       // the driver stamps buffers on CLOCK_MONOTONIC
+    v4l2_buffer_map_t buffers[V4L2_MAX_BUFFERS];
+} v4l2_capture_t;
+
+/*
+ * @brief Function to open the device, set the format and mmap num_buffers driver buffers. Fails when the driver
+ *        does not give exactly the requested size, the whole pipeline is sized for it
+ */
+int v4l2_capture_open(v4l2_capture_t *cap, const char *device, int width, int height, uint32_t pixfmt, unsigned num_buffers);
+
+/*
+ * @brief Function to queue all the buffers and start streaming
+ */
+int v4l2_capture_start(v4l2_capture_t *cap);
+
+/*
+ * @brief Function to stop streaming, all frames handed out become invalid
+ */
+int v4l2_capture_stop(v4l2_capture_t *cap);
+
+/*
+ * @brief Function to wait up to timeout_ms for the next filled buffer, returns 1 with a frame, 0 on timeout, -1 on error
+ */
+int v4l2_capture_dequeue(v4l2_capture_t *cap, v4l2_frame_t *frame, int timeout_ms);
+
+/*
+ * @brief Function to give a frame back to the driver
+ */
+int v4l2_capture_requeue(v4l2_capture_t *cap, const v4l2_frame_t *frame);
+
+/*
+ * @brief Function to unmap the buffers and close the device
+ */
+void v4l2_capture_close(v4l2_capture_t *cap);
+
+#endif
@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    vehicle_sim.cpp
+ * @brief   This file contains definition of the simulated vehicle and the wall in front of it
+ * @date    18th October 2026
+ *
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "vehicle_sim.h"
+#include "service_stats.h"
+#include "rt_time.h"
+
+#define VEHICLE_SIM_REST_MM_S (1.0)    // slower than this counts as standing still
+
+typedef struct
+{
+    int duty;
+    int direction;
+    double speed_mm_s;
+} sim_motor_t;
+
+static pthread_mutex_t sim_lock;   // taken by the motor, ultrasonic and main threads
+static bool sim_lock_ready = false;
+static sim_motor_t motors[2];
+static double position_mm;         // towards the wall from the start
+static uint64_t start_ns, last_ns;
+static int threshold_mm;
+static vehicle_sim_result_t result;
+
+static double motor_target(const sim_motor_t *m)
+{
+    double speed = VEHICLE_SIM_MAX_SPEED_MM_S * m->duty / (VEHICLE_SIM_PWM_RANGE - 1);
+
+    return m->direction ? speed : -speed;
+}
+
+static double vehicle_speed(void)
+{
+    return (motors[0].speed_mm_s + motors[1].speed_mm_s) / 2.0;
+}
+
+// Advance the state to now, the motor inputs were constant since the last update
+static void sim_update_locked(uint64_t now)
+{
+    double dt = (now - last_ns) / (double)NSEC_PER_SEC;
+    double before = position_mm, moved = 0.0, gap;
+
+    if(now <= last_ns) return;
+    last_ns = now;
+
+    for(int m = 0; m < 2; m++)
+    {
+        sim_motor_t *motor = &motors[m];
+        double target = motor_target(motor);
+        double tau = (fabs(target) < fabs(motor->speed_mm_s)) ? VEHICLE_SIM_TAU_BRAKE_S : VEHICLE_SIM_TAU_ACCEL_S;
+        double decay = exp(-dt / tau);
+
+        moved += target * dt + (motor->speed_mm_s - target) * tau * (1.0 - decay);
+        motor->speed_mm_s = target + (motor->speed_mm_s - target) * decay;
+    }
+    position_mm += moved / 2.0;
+
+    if(vehicle_speed() > result.peak_speed_mm_s) result.peak_speed_mm_s = vehicle_speed();
+
+    // Crossings are placed by linear interpolation over the update interval
+    gap = result.wall_mm - position_mm;
+    if((result.threshold_crossed_s < 0) && (gap < threshold_mm) && (position_mm > before))
+        result.threshold_crossed_s = (now - start_ns) / (double)NSEC_PER_SEC - dt * (threshold_mm - gap) / (position_mm - before);
+
+    if(position_mm >= result.wall_mm)
+    {
+        position_mm = result.wall_mm;
+        motors[0].speed_mm_s = motors[1].speed_mm_s = 0.0;
+        result.collided = true;
+        result.settled = true;
+        result.rest_gap_mm = 0.0;
+    }
+
+    if(result.stopped && !result.settled && (fabs(vehicle_speed()) < VEHICLE_SIM_REST_MM_S))
+    {
+        result.settled = true;
+        result.rest_gap_mm = result.wall_mm - position_mm;
+    }
+}
+
+void vehicle_sim_init(int wall_mm, int stop_threshold_mm)
+{
+    pthread_mutexattr_t lock_attr;
+
+    if(!sim_lock_ready)
+    {
+        // Priority inheritance, the motor stop path takes it
+        pthread_mutexattr_init(&lock_attr);
+        pthread_mutexattr_setprotocol(&lock_attr, PTHREAD_PRIO_INHERIT);
+        pthread_mutex_init(&sim_lock, &lock_attr);
+        pthread_mutexattr_destroy(&lock_attr);
+        sim_lock_ready = true;
+    }
+
+    pthread_mutex_lock(&sim_lock);
+    for(int m = 0; m < 2; m++)
+    {
+        motors[m].duty = 0;
+        motors[m].direction = 1;
+        motors[m].speed_mm_s = 0.0;
+    }
+    position_mm = 0.0;
+    threshold_mm = stop_threshold_mm;
+    start_ns = last_ns = rt_now();
+
+    result = vehicle_sim_result_t();
+    result.wall_mm = wall_mm;
+    result.threshold_crossed_s = -1.0;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void vehicle_sim_set_duty(int motor, int duty)
+{
+    pthread_mutex_lock(&sim_lock);
+    sim_update_locked(rt_now());
+    motors[motor].duty = duty;
+
+    // Both duties at zero while driving forward is the stop being measured
+    if(!result.stopped && (motors[0].duty == 0) && (motors[1].duty == 0) && (vehicle_speed() > VEHICLE_SIM_REST_MM_S))
+    {
+        result.stopped = true;
+        result.stop_command_s = (last_ns - start_ns) / (double)NSEC_PER_SEC;
+        result.stop_speed_mm_s = vehicle_speed();
+        result.stop_gap_mm = result.wall_mm - position_mm;
+    }
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void vehicle_sim_set_direction(int motor, int direction)
+{
+    pthread_mutex_lock(&sim_lock);
+    sim_update_locked(rt_now());
+    motors[motor].direction = direction;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+int vehicle_sim_range_mm(void)
+{
+    double gap;
+
+    pthread_mutex_lock(&sim_lock);
+    sim_update_locked(rt_now());
+    gap = result.wall_mm - position_mm;
+    pthread_mutex_unlock(&sim_lock);
+    return (int)lround(gap);
+}
+
+void vehicle_sim_result(vehicle_sim_result_t *out)
+{
+    pthread_mutex_lock(&sim_lock);
+    sim_update_locked(rt_now());
+    *out = result;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void vehicle_sim_report(FILE *out, const char *extra)
+{
+    vehicle_sim_result_t r;
+
+    vehicle_sim_result(&r);
+    fprintf(out, "{\"bench\":\"stopping_distance\",\"wall_mm\":%d,\"threshold_mm\":%d,\"peak_speed_mm_s\":%.0f,"
+                 "\"stopped\":%s,\"stop_speed_mm_s\":%.0f,\"threshold_to_stop_ms\":%.1f,\"stop_gap_mm\":%.1f,"
+                 "\"rest_gap_mm\":%.1f,\"braking_mm\":%.1f,\"collided\":%s%s%s}\n",
+            r.wall_mm, threshold_mm, r.peak_speed_mm_s, r.stopped ? "true" : "false", r.stop_speed_mm_s,
+            ((r.threshold_crossed_s >= 0) && r.stopped) ? (r.stop_command_s - r.threshold_crossed_s) * 1000.0 : 0.0,
+            r.stop_gap_mm, r.rest_gap_mm, (r.stopped && r.settled) ? r.stop_gap_mm - r.rest_gap_mm : 0.0,
+            r.collided ? "true" : "false", extra ? "," : "", extra ? extra : "");
+    fflush(out);
+}
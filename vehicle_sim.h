@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * Copyright (C) 2024 by Krishna Suhagiya and Unmesh Phaterpekar
+ *
+ * Redistribution, modification or use of this software in source or binary
+ * forms is permitted as long as the files maintain this copyright. Users are
+ * permitted to modify this and use it to learn about the field of embedded
+ * software. Krishna Suhagiya, Unmesh Phaterpekar and the University of Colorado are not liable for
+ * any misuse of this material.
+ * ****************************************************************************/
+
+/**
+ * @file    vehicle_sim.h
+ * @brief   This file contains declaration of the simulated vehicle and the wall in front of it
+ * @date    18th October 2026
+ *
+ * The vehicle moves along a line towards a wall. Each motor's speed follows its
+ * PWM duty with a first order lag, and the vehicle speed is the mean of both
+ * motors. A faster time constant is used when slowing down, because the driver
+ * short-brakes at zero duty. The state is integrated in closed form whenever
+ * it is read or a motor input changes, so time runs on CLOCK_MONOTONIC with no
+ * thread of its own. The vehicle stops dead at the wall, which counts as a
+ * collision.
+ *
+ * The plant also measures the stop: where the vehicle was when both duties went
+ * to zero, and where it came to rest.
+ */
+
+#ifndef _VEHICLE_SIM_H
+#define _VEHICLE_SIM_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define VEHICLE_SIM_DEFAULT_WALL_MM (1500)
+#define VEHICLE_SIM_MAX_SPEED_MM_S (800.0)   // both motors at full duty
+#define VEHICLE_SIM_TAU_ACCEL_S (0.20)
+#define VEHICLE_SIM_TAU_BRAKE_S (0.08)
+#define VEHICLE_SIM_PWM_RANGE (1024)
+
+typedef struct
+{
+    int wall_mm;                   // initial gap to the wall
+    bool stopped;                  // a stop command came while moving forward
+    bool settled;                  // at rest after the stop command
+    bool collided;
+    double peak_speed_mm_s;
+    double threshold_crossed_s;    // time since start the gap fell below the stop threshold, < 0 for never
+    double stop_command_s;         // time since start of the stop command
+    double stop_speed_mm_s;        // speed when the stop command came
+    double stop_gap_mm;            // gap when the stop command came
+    double rest_gap_mm;            // gap at rest, 0 after a collision
+} vehicle_sim_result_t;
+
+/*
+ * @brief Function to place the vehicle at rest wall_mm from the wall, threshold_mm is the gap the stop should happen at
+ */
+void vehicle_sim_init(int wall_mm, int threshold_mm);
+
+/*
+ * @brief Function to set the PWM duty of one motor
+ */
+void vehicle_sim_set_duty(int motor, int duty);
+
+/*
+ * @brief Function to set the direction of one motor, 1 forward
+ */
+void vehicle_sim_set_direction(int motor, int direction);
+
+/*
+ * @brief Function to get the gap to the wall now in mm, what an ideal range sensor reads
+ */
+int vehicle_sim_range_mm(void);
+
+/*
+ * @brief Function to get the stop measurement so far
+ */
+void vehicle_sim_result(vehicle_sim_result_t *result);
+
+/*
+ * @brief Function to print the stop measurement as one JSON object, extra is spliced in as more members when not NULL
+ */
+void vehicle_sim_report(FILE *out, const char *extra);
+
+#endif